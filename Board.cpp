@@ -1,109 +1,247 @@
 #include "Board.h"
+#include "CellMask.h"
+#include "FixedBoard.h"
+#include "Fleet.h"
 #include "Game.h"
+#include "PlacementTable.h"
 #include "globals.h"
 #include <iostream>
+#include <memory>
+#include <unordered_map>
 #include <vector>
-#include <map>
 
 using namespace std;
 
+// Interface shared by the board representations -- small boards are kept
+// as bit masks, large ones only store ship and shot cells
 class BoardImpl
 {
 public:
     // Constructor
-    BoardImpl(const Game& g);
+    BoardImpl(const Game& g) : m_game(g), m_rows(g.rows()), m_cols(g.cols()), m_nShips(g.nShips()) {}
+    // Destructor
+    virtual ~BoardImpl() {}
     
     // Other
-    void clear();
-    void block();
-    void unblock();
-    bool placeShip(Point topOrLeft, int shipId, Direction dir);
-    bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    virtual void clear() = 0;
+    virtual void block() = 0;
+    virtual void unblock() = 0;
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir) = 0;
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir) = 0;
     void display(bool shotsOnly) const;
-    bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
-    bool allShipsDestroyed() const { return m_shipsInPlay.empty(); }
+    void render(string& frame, bool shotsOnly) const;
+    Point framePosition(Point p) const;
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId) = 0;
+    virtual bool allShipsDestroyed() const = 0;
+    // Character displayed for a cell
+    virtual char cellChar(int r, int c, bool shotsOnly) const = 0;
     
-private:
-    vector<vector<char> > m_board;
-    map<int, int> m_shipsInPlay;
+protected:
     const Game& m_game;
+    int m_rows, m_cols, m_nShips;
 };
 
 /**
-    BoardImpl constructor
+    Returns the number of decimal digits needed to write n
+ */
+static int nDigits(int n)
+{
+    int d = 1;
+    for (; n >= 10; n /= 10)
+        d++;
+    return d;
+}
+
+/**
+    Appends n to a frame, right-aligned in a field
  
-    @param1 g Game object which holds rows, columns, and other pieces of game info
-    Utilizes a 2D vector to store the board
-    Utilizes an unordered set to store ship ids added to the board
+    @param1 frame The frame being built
+    @param2 n The number -- not negative
+    @param3 width Width of the field
+ */
+static void appendNumber(string& frame, int n, int width)
+{
+    char digits[12];
+    int len = 0;
+    do
+    {
+        digits[len++] = static_cast<char>('0' + n % 10);
+        n /= 10;
+    } while (n > 0);
+    frame.append(width > len ? width - len : 0, ' ');
+    while (len > 0)
+        frame += digits[--len];
+}
+
+/** Displays the board
+ 
+    @param1 shotsOnly If true board only displays both missed and hit shots
+    The frame is built in a buffer and written with one call, without flushing
  */
-BoardImpl::BoardImpl(const Game& g)
-: m_game(g), m_shipsInPlay({})
+void BoardImpl::display(bool shotsOnly) const
+{
+    // Each thread keeps its buffer, so once it has grown displaying does not allocate
+    thread_local string frame;
+    frame.clear();
+    render(frame, shotsOnly);
+    cout.write(frame.data(), frame.size());
+}
+
+/** Appends the text of the board to a frame
+ 
+    @param1 frame Where the text goes -- every line ends in a newline
+    @param2 shotsOnly If true board only displays both missed and hit shots
+    Column numbers with more than one digit are written top to bottom so each column stays one character wide
+ */
+void BoardImpl::render(string& frame, bool shotsOnly) const
 {
-    // Resize the outer vector to the number of rows in the game
-    m_board.resize(g.rows());
-    for (int r = 0; r < g.rows(); r++)
+    int rowWidth = nDigits(m_rows - 1);
+    int colDigits = nDigits(m_cols - 1);
+    frame.reserve(frame.size() + (colDigits + m_rows) * (rowWidth + 2 + m_cols));
+    // Output top rows -- one per digit of the column numbers
+    for (int place = colDigits - 1; place >= 0; place--)
     {
-        // Resize the inner vector to the number of columns in the game
-        m_board[r].resize(g.cols());
-        for (int c = 0; c < g.cols(); c++)
+        int scale = 1;
+        for (int k = 0; k < place; k++)
+            scale *= 10;
+        frame.append(rowWidth + 1, ' ');
+        for (int n = 0; n < m_cols; n++)
         {
-            m_board[r][c] = '.';
+            // Leading zeros are left blank
+            if (place > 0 && n < scale)
+                frame += ' ';
+            else
+                frame += static_cast<char>('0' + (n / scale) % 10);
         }
+        frame += '\n';
     }
+    
+    // Output remainder of the board
+    for (int r = 0; r < m_rows; r++)
+    {
+        appendNumber(frame, r, rowWidth);
+        frame += ' ';
+        for (int c = 0; c < m_cols; c++)
+            frame += cellChar(r, c, shotsOnly);
+        frame += '\n';
+    }
+}
+
+/**
+    Returns where a cell is drawn in the frame render builds
+ 
+    @param1 p The cell
+    @return Line and column of the cell's character, counting from 0
+ */
+Point BoardImpl::framePosition(Point p) const
+{
+    return Point(nDigits(m_cols - 1) + p.r, nDigits(m_rows - 1) + 1 + p.c);
+}
+
+//*********************************************************************
+//  MaskBoardImpl
+//*********************************************************************
+
+// A board of at most MASKCELLS cells, stored as one bit per cell
+class MaskBoardImpl : public BoardImpl
+{
+public:
+    // Constructor
+    MaskBoardImpl(const Game& g);
+    
+    // Other
+    virtual void clear();
+    virtual void block();
+    virtual void unblock();
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir);
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    virtual bool allShipsDestroyed() const { return (m_occupied & ~m_hits).none(); }
+    virtual char cellChar(int r, int c, bool shotsOnly) const;
+    
+private:
+    // Mask of the cells a ship would cover -- empty if it would not fit
+    CellMask shipMask(Point topOrLeft, int shipId, Direction dir) const;
+    
+    // Cells covered by any ship, shot at, hit, and blocked during placement
+    CellMask m_occupied, m_shots, m_hits, m_blocked;
+    // Every cell of the board
+    CellMask m_cells;
+    // Cells covered by each ship -- empty while the ship is not in play
+    vector<CellMask> m_shipCells;
+    // The geometry's placements, and each ship's length class in it
+    shared_ptr<const PlacementTable> m_table;
+    vector<int> m_lengthIndex;
+};
+
+/**
+    MaskBoardImpl constructor
+ 
+    @param1 g Game object which holds rows, columns, and other pieces of game info
+    Utilizes bit masks with one bit per cell to store the board
+    Ship masks come from the game's placement table, so placing a ship is a lookup
+ */
+MaskBoardImpl::MaskBoardImpl(const Game& g)
+: BoardImpl(g),
+  m_cells(CellMask::firstN(g.rows() * g.cols())),
+  m_shipCells(g.nShips()), m_table(g.placements()), m_lengthIndex(g.nShips())
+{
+    for (int id = 0; id < m_nShips; id++)
+        m_lengthIndex[id] = m_table->lengthIndex(g.shipLength(id));
 }
 
 /**
     Clears the board
-    Iterates through board and sets cells back to .
+    Removes every ship, shot and blocked cell
  */
-void BoardImpl::clear()
+void MaskBoardImpl::clear()
 {
-    for (int r = 0; r < m_game.rows(); r++)
-    {
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            m_board[r][c] = '.';
-        }
-    }
+    m_occupied = m_shots = m_hits = m_blocked = CellMask();
+    for (int id = 0; id < m_nShips; id++)
+        m_shipCells[id] = CellMask();
 }
 
 /**
     Blocks the board
-    Marks ~50% of the board as blocked by randomly placing X's
+    Marks ~50% of the board as blocked with one random bit per cell
     Only used by mediocre player
  */
-void BoardImpl::block()
+void MaskBoardImpl::block()
 {
-    // Block cells with 50% probability
-    for (int r = 0; r < m_game.rows(); r++)
-    {
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            if (randInt(2) == 0)
-            {
-                m_board[r][c] = 'X';
-            }
-        }
-    }
+    // Cell i is blocked if random bit i is clear -- the whole mask at once
+    uint64_t words[2];
+    m_game.rng().fill(words, 2);
+    m_blocked = ~CellMask(words[0], words[1]) & m_cells & ~m_occupied;
 }
 
 /**
     Unblocks the board
-    Iterates through board and sets X's back to .'s
     Only used by mediocre player
  */
-void BoardImpl::unblock()
+void MaskBoardImpl::unblock()
 {
-    for (int r = 0; r < m_game.rows(); r++)
-    {
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            if (m_board[r][c] == 'X')
-            {
-                m_board[r][c] = '.';
-            }
-        }
-    }
+    m_blocked = CellMask();
+}
+
+/**
+    Computes the cells a ship would cover
+ 
+    @param1 topOrLeft The coordinate of the topmost of leftmost segment of the ship
+    @param2 shipId The id of the ship
+    @param3 dir The orientation of the ship -- VERTICAL or HORIZONTAL
+    @return Mask of the covered cells, empty if the ship would leave the board
+ */
+CellMask MaskBoardImpl::shipMask(Point topOrLeft, int shipId, Direction dir) const
+{
+    // If shipId is not valid or point is out of bounds there is no mask
+    if (shipId < 0 || shipId > m_nShips - 1)
+        return CellMask();
+    if (topOrLeft.r < 0 || topOrLeft.r > m_rows - 1 || topOrLeft.c < 0 || topOrLeft.c > m_cols - 1)
+        return CellMask();
+    // The table has no placement where the ship would leave the board
+    int li = m_lengthIndex[shipId];
+    int pl = m_table->placementAt(li, topOrLeft.r * m_cols + topOrLeft.c, dir);
+    return pl < 0 ? CellMask() : m_table->mask(li, pl);
 }
 
 /**
@@ -114,54 +252,18 @@ void BoardImpl::unblock()
     @param3 dir The orientation of the ship being placed -- VERTICAL or HORIZONTAL
     @return True if the ship is successfully placed else false
  */
-bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
+bool MaskBoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
 {
-    // If shipId is not valid return false
-    if (shipId < 0 || shipId > m_game.nShips() - 1)
+    CellMask mask = shipMask(topOrLeft, shipId, dir);
+    // If ship does not fit or is already in play return false
+    if (mask.none() || m_shipCells[shipId].any())
         return false;
-    // If point is out of bounds return false
-    if (topOrLeft.r < 0 || topOrLeft.r > m_game.rows() - 1 || topOrLeft.c < 0 || topOrLeft.c > m_game.cols() - 1)
+    // If any slot for the ship is not empty return false
+    if ((mask & (m_occupied | m_shots | m_blocked)).any())
         return false;
-    // If ship is already in play return false
-    if (m_shipsInPlay.find(shipId) != m_shipsInPlay.end())
-        return false;
-    int len = m_game.shipLength(shipId);
-    // Horizontal placement
-    if (dir == HORIZONTAL)
-    {
-        Point left = topOrLeft;
-        // Check length to make sure ship fits
-        if (left.c + len > m_game.cols())
-            return false;
-        for (int i = 0; i < len; i++)
-        {
-            // If slot for ship is not empty return false
-            if (m_board[left.r][left.c+i] != '.')
-                return false;
-        }
-        // Place ship on board
-        for (int i = 0; i < len; i++)
-            m_board[left.r][left.c+i] = shipId+'0';
-    }
-    // Vertical placement
-    else // dir == VERTICAL
-    {
-        Point top = topOrLeft;
-        // Check length to make sure ship fits
-        if (top.r + len > m_game.rows())
-            return false;
-        for (int i = 0; i < len; i++)
-        {
-            // If slot for ship is not empty return false
-            if (m_board[top.r+i][top.c] != '.')
-                return false;
-        }
-        // Place ship on board
-        for (int i = 0; i < len; i++)
-            m_board[top.r+i][top.c] = shipId+'0';
-    }
-    // Add to ships in play and return true
-    m_shipsInPlay.insert(make_pair(shipId, m_game.shipLength(shipId)));
+    // Place ship on board
+    m_occupied |= mask;
+    m_shipCells[shipId] = mask;
     return true;
 }
 
@@ -172,89 +274,349 @@ bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
     @param3 dir The orientation of the ship being removed -- VERTICAL or HORIZONTAL
     @return True if the ship is successfully removed else false
  */
-bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+bool MaskBoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 {
-    // If shipId is not valid return false
-    if (shipId < 0 || shipId > m_game.nShips() - 1)
+    CellMask mask = shipMask(topOrLeft, shipId, dir);
+    // If ship is not in play at exactly these cells return false
+    if (mask.none() || m_shipCells[shipId] != mask)
         return false;
-    // If out of bounds return false
-    if (dir == VERTICAL && topOrLeft.r + m_game.shipLength(shipId) > m_game.rows())
+    // A ship that has been hit is no longer intact and cannot be removed
+    if ((mask & m_hits).any())
         return false;
-    // If out of bounds return false
-    if (dir == HORIZONTAL && topOrLeft.c + m_game.shipLength(shipId) > m_game.cols())
-        return false;
-    // If out of bounds return false
-    if (topOrLeft.r < 0 || topOrLeft.r > m_game.rows() - 1 || topOrLeft.c < 0 || topOrLeft.c > m_game.cols() - 1)
-        return false;
-    // If ship is not in play return false
-    if (m_shipsInPlay.find(shipId) == m_shipsInPlay.end())
+    // Remove ship from board
+    m_occupied &= ~mask;
+    m_shipCells[shipId] = CellMask();
+    return true;
+}
+
+/**
+    Returns the character displayed for a cell
+ 
+    @param1 r Row of the cell
+    @param2 c Column of the cell
+    @param3 shotsOnly If true unattacked ship segments are hidden
+ */
+char MaskBoardImpl::cellChar(int r, int c, bool shotsOnly) const
+{
+    int i = r * m_cols + c;
+    if (m_hits.test(i) || m_blocked.test(i))
+        return 'X';
+    if (m_shots.test(i))
+        return 'o';
+    if (!m_occupied.test(i) || shotsOnly)
+        return '.';
+    // Cell contains an unattacked boat segment
+    int id = 0;
+    while (!m_shipCells[id].test(i))
+        id++;
+    return m_game.shipSymbol(id);
+}
+
+/**
+    Attacks coordinate on the board
+ 
+    @param1 p Point to attack
+    @param2 shotHit Set to true if shot hits a ship
+    @param3 shipDestroyed Set to true of a ship is destroyed
+    @param4 shipId Set to shipId of ship hit
+    @return True if shot is valid -- meaning point is inbounds and has not already been shot
+ */
+bool MaskBoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+{
+    // If shot is out of bounds return false
+    if (p.r < 0 || p.r > m_rows - 1 || p.c < 0 || p.c > m_cols - 1)
+    {
+        // Used to let Game::play() know user wasted shot
+        shipId = -1;
         return false;
-    int len = m_game.shipLength(shipId);
-    // Direction is horizontal
-    if (dir == HORIZONTAL)
+    }
+    int i = p.r * m_cols + p.c;
+    // If cell already shot return false
+    if (m_shots.test(i) || m_blocked.test(i))
     {
-        Point left = topOrLeft;
-        for (int i = 0; i < len; i++)
-        {
-            // If slot does not equal the shipId return false
-            if (m_board[left.r][left.c+i]-48 != shipId)
-                return false;
-        }
-        // Remove ship from board
-        for (int i = 0; i < len; i++)
-            m_board[left.r][left.c+i] = '.';
+        shipId = -1;
+        return false;
     }
-    // Direction is vertical
-    else // dir == VERTICAL
+    m_shots.set(i);
+    shotHit = m_occupied.test(i);
+    shipDestroyed = false;
+    // Hit a ship
+    if (shotHit)
     {
-        Point top = topOrLeft;
-        for (int i = 0; i < len; i++)
-        {
-            // If slot does not equal shipId return false
-            if (m_board[top.r+i][top.c]-48 != shipId)
-                return false;
-        }
-        // Remove ship from board
-        for (int i = 0; i < len; i++)
-            m_board[top.r+i][top.c] = '.';
+        m_hits.set(i);
+        // Find the ship covering the cell
+        for (shipId = 0; !m_shipCells[shipId].test(i); shipId++)
+            ;
+        // The ship is destroyed once all of its cells are hit
+        shipDestroyed = (m_shipCells[shipId] & ~m_hits).none();
     }
-    // Erase ship from ships in play and return true
-    m_shipsInPlay.erase(shipId);
+    // Return true
     return true;
 }
 
-/** Displays the board
+//*********************************************************************
+//  FixedBoardImpl
+//*********************************************************************
+
+// A board whose geometry and fleet are known at compile time -- the rules
+// are FixedBoard's, with constant bounds and a constexpr placement table
+template <int Rows, int Cols, class Fleet>
+class FixedBoardImpl : public BoardImpl
+{
+public:
+    // Constructor
+    FixedBoardImpl(const Game& g) : BoardImpl(g) {}
+    
+    // Other
+    virtual void clear() { m_board.clear(); }
+    virtual void block() { m_board.block(m_game.rng()); }
+    virtual void unblock() { m_board.unblock(); }
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir)
+    {
+        return m_board.placeShip(topOrLeft, shipId, dir);
+    }
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir)
+    {
+        return m_board.unplaceShip(topOrLeft, shipId, dir);
+    }
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+    {
+        return m_board.attack(p, shotHit, shipDestroyed, shipId);
+    }
+    virtual bool allShipsDestroyed() const { return m_board.allShipsDestroyed(); }
+    virtual char cellChar(int r, int c, bool shotsOnly) const;
+    
+private:
+    FixedBoard<Rows, Cols, Fleet> m_board;
+};
+
+/**
+    Returns the character displayed for a cell
  
-    @param1 shotsOnly If true board only displays both missed and hit shots
+    @param1 r Row of the cell
+    @param2 c Column of the cell
+    @param3 shotsOnly If true unattacked ship segments are hidden
  */
-void BoardImpl::display(bool shotsOnly) const
+template <int Rows, int Cols, class Fleet>
+char FixedBoardImpl<Rows, Cols, Fleet>::cellChar(int r, int c, bool shotsOnly) const
 {
-    // Output top row
-    cout << "  ";
-    for (int n = 0; n < m_game.cols(); n++)
-        cout << n;
-    cout << endl;
+    int i = r * Cols + c;
+    if (m_board.hits().test(i) || m_board.blocked().test(i))
+        return 'X';
+    if (m_board.shots().test(i))
+        return 'o';
+    if (!m_board.occupied().test(i) || shotsOnly)
+        return '.';
+    // Cell contains an unattacked boat segment
+    int id = 0;
+    while (!m_board.shipCells(id).test(i))
+        id++;
+    return m_game.shipSymbol(id);
+}
+
+//*********************************************************************
+//  SparseBoardImpl
+//*********************************************************************
+
+// A board of any size that only stores the cells covered by ships and the
+// cells shot at, so memory and time per shot do not grow with rows*cols
+class SparseBoardImpl : public BoardImpl
+{
+public:
+    // Constructor
+    SparseBoardImpl(const Game& g);
     
-    // Output remainder of the board
-    for (int r = 0; r < m_game.rows(); r++)
+    // Other
+    virtual void clear();
+    virtual void block();
+    virtual void unblock();
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir);
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    virtual bool allShipsDestroyed() const { return m_cellsLeft == 0; }
+    virtual char cellChar(int r, int c, bool shotsOnly) const;
+    
+private:
+    // Where a ship is -- inPlay is false while it is not on the board
+    struct Ship
     {
-        cout << r << " ";
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            if (m_board[r][c] == '.' || m_board[r][c] == 'o' || m_board[r][c] == 'X')
-                cout << m_board[r][c];
-            else // board cell contains an unattacked boat segment
-            {
-                if (shotsOnly)
-                    cout << '.';
-                else
-                    cout << m_game.shipSymbol(m_board[r][c]-48);
-            }
-        }
-        cout << endl;
+        int m_cell;
+        Direction m_dir;
+        int m_len;
+        int m_hitsLeft;
+        bool m_inPlay;
+    };
+    // Returns true if a ship can be laid on the cells
+    bool fits(Point topOrLeft, int shipId, Direction dir) const;
+    // Blocking is a pseudo-random function of the cell, so it costs no memory
+    bool isBlocked(int cell) const
+    {
+        return m_blocking && m_occupied.count(cell) == 0 &&
+               (Rng::mix(m_blockSalt ^ static_cast<uint64_t>(cell)) & 1) == 0;
+    }
+    
+    vector<Ship> m_ships;
+    // Cell index to the id of the ship covering it
+    unordered_map<int, int> m_occupied;
+    // Cell index to whether the shot there hit
+    unordered_map<int, bool> m_shots;
+    // Number of ship cells not yet hit
+    int m_cellsLeft;
+    bool m_blocking;
+    uint64_t m_blockSalt;
+};
+
+/**
+    SparseBoardImpl constructor
+ 
+    @param1 g Game object which holds rows, columns, and other pieces of game info
+    Utilizes hash maps holding only the ship cells and the shots
+ */
+SparseBoardImpl::SparseBoardImpl(const Game& g)
+: BoardImpl(g), m_ships(g.nShips()), m_cellsLeft(0), m_blocking(false), m_blockSalt(0)
+{
+    for (int id = 0; id < m_nShips; id++)
+    {
+        m_ships[id].m_len = g.shipLength(id);
+        m_ships[id].m_inPlay = false;
     }
 }
 
+/**
+    Clears the board
+    Removes every ship, shot and blocked cell
+ */
+void SparseBoardImpl::clear()
+{
+    m_occupied.clear();
+    m_shots.clear();
+    for (Ship& s : m_ships)
+        s.m_inPlay = false;
+    m_cellsLeft = 0;
+    m_blocking = false;
+}
+
+/**
+    Blocks the board
+    Marks ~50% of the board as blocked by drawing a new salt for isBlocked
+    Only used by mediocre player
+ */
+void SparseBoardImpl::block()
+{
+    m_blocking = true;
+    m_blockSalt = m_game.rng().next();
+}
+
+/**
+    Unblocks the board
+    Only used by mediocre player
+ */
+void SparseBoardImpl::unblock()
+{
+    m_blocking = false;
+}
+
+/**
+    Checks whether a ship can be placed
+ 
+    @param1 topOrLeft The coordinate of the topmost of leftmost segment of the ship
+    @param2 shipId The id of the ship
+    @param3 dir The orientation of the ship -- VERTICAL or HORIZONTAL
+    @return True if the ship is on the board and every cell is empty, unshot and unblocked
+ */
+bool SparseBoardImpl::fits(Point topOrLeft, int shipId, Direction dir) const
+{
+    int len = m_ships[shipId].m_len;
+    if (dir == HORIZONTAL ? topOrLeft.c + len > m_cols : topOrLeft.r + len > m_rows)
+        return false;
+    int cell = topOrLeft.r * m_cols + topOrLeft.c;
+    int step = (dir == HORIZONTAL ? 1 : m_cols);
+    for (int i = 0; i < len; i++, cell += step)
+        if (m_occupied.count(cell) != 0 || m_shots.count(cell) != 0 || isBlocked(cell))
+            return false;
+    return true;
+}
+
+/**
+    Places a ship on the board
+ 
+    @param1 topOrLeft The coordinate of the topmost of leftmost segment of the ship
+    @param2 shipId The id of the ship being placed
+    @param3 dir The orientation of the ship being placed -- VERTICAL or HORIZONTAL
+    @return True if the ship is successfully placed else false
+ */
+bool SparseBoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
+{
+    // If shipId is not valid or point is out of bounds return false
+    if (shipId < 0 || shipId > m_nShips - 1)
+        return false;
+    if (topOrLeft.r < 0 || topOrLeft.r > m_rows - 1 || topOrLeft.c < 0 || topOrLeft.c > m_cols - 1)
+        return false;
+    Ship& s = m_ships[shipId];
+    // If ship is already in play or does not fit return false
+    if (s.m_inPlay || !fits(topOrLeft, shipId, dir))
+        return false;
+    // Place ship on board
+    s.m_cell = topOrLeft.r * m_cols + topOrLeft.c;
+    s.m_dir = dir;
+    s.m_hitsLeft = s.m_len;
+    s.m_inPlay = true;
+    int step = (dir == HORIZONTAL ? 1 : m_cols);
+    for (int i = 0; i < s.m_len; i++)
+        m_occupied[s.m_cell + i * step] = shipId;
+    m_cellsLeft += s.m_len;
+    return true;
+}
+
+/** Remove a ship on the board
+ 
+    @param1 topOrLeft The coordinate of the topmost of leftmost segment of the ship
+    @param2 shipId The id of the ship being removed
+    @param3 dir The orientation of the ship being removed -- VERTICAL or HORIZONTAL
+    @return True if the ship is successfully removed else false
+ */
+bool SparseBoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+{
+    // If shipId is not valid or point is out of bounds return false
+    if (shipId < 0 || shipId > m_nShips - 1)
+        return false;
+    if (topOrLeft.r < 0 || topOrLeft.r > m_rows - 1 || topOrLeft.c < 0 || topOrLeft.c > m_cols - 1)
+        return false;
+    Ship& s = m_ships[shipId];
+    // If ship is not in play exactly here, or has been hit, return false
+    if (!s.m_inPlay || s.m_cell != topOrLeft.r * m_cols + topOrLeft.c || s.m_dir != dir ||
+        s.m_hitsLeft != s.m_len)
+        return false;
+    // Remove ship from board
+    int step = (dir == HORIZONTAL ? 1 : m_cols);
+    for (int i = 0; i < s.m_len; i++)
+        m_occupied.erase(s.m_cell + i * step);
+    s.m_inPlay = false;
+    m_cellsLeft -= s.m_len;
+    return true;
+}
+
+/**
+    Returns the character displayed for a cell
+ 
+    @param1 r Row of the cell
+    @param2 c Column of the cell
+    @param3 shotsOnly If true unattacked ship segments are hidden
+ */
+char SparseBoardImpl::cellChar(int r, int c, bool shotsOnly) const
+{
+    int cell = r * m_cols + c;
+    auto shot = m_shots.find(cell);
+    if (shot != m_shots.end())
+        return shot->second ? 'X' : 'o';
+    if (isBlocked(cell))
+        return 'X';
+    auto ship = m_occupied.find(cell);
+    if (ship == m_occupied.end() || shotsOnly)
+        return '.';
+    return m_game.shipSymbol(ship->second);
+}
+
 /**
     Attacks coordinate on the board
  
@@ -264,45 +626,33 @@ void BoardImpl::display(bool shotsOnly) const
     @param4 shipId Set to shipId of ship hit
     @return True if shot is valid -- meaning point is inbounds and has not already been shot
  */
-bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+bool SparseBoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
     // If shot is out of bounds return false
-    if (p.r < 0 || p.r > m_game.rows() || p.c < 0 || p.c > m_game.rows())
+    if (p.r < 0 || p.r > m_rows - 1 || p.c < 0 || p.c > m_cols - 1)
     {
         // Used to let Game::play() know user wasted shot
         shipId = -1;
         return false;
     }
-    
+    int cell = p.r * m_cols + p.c;
     // If cell already shot return false
-    if (m_board[p.r][p.c] == 'o' || m_board[p.r][p.c] == 'X')
+    if (m_shots.count(cell) != 0 || isBlocked(cell))
     {
         shipId = -1;
         return false;
     }
-    // If cell is empty mark with missed
-    else if (m_board[p.r][p.c] == '.')
-    {
-        shotHit = false;
-        shipDestroyed = false;
-        m_board[p.r][p.c] = 'o';
-    }
+    auto ship = m_occupied.find(cell);
+    shotHit = (ship != m_occupied.end());
+    shipDestroyed = false;
+    m_shots[cell] = shotHit;
     // Hit a ship
-    else
+    if (shotHit)
     {
-        // Set variables to shipId and mark board as hit
-        shotHit = true;
-        shipId = m_board[p.r][p.c]-48;
-        m_board[p.r][p.c] = 'X';
-        // Decrement ships health
-        m_shipsInPlay[shipId]--;
-        // If the ships health is zero shipDestroyed is true
-        if (m_shipsInPlay[shipId] == 0)
-        {
-            shipDestroyed = true;
-            // Erase ship from ships in play
-            m_shipsInPlay.erase(shipId);
-        }
+        shipId = ship->second;
+        m_cellsLeft--;
+        // The ship is destroyed once all of its cells are hit
+        shipDestroyed = (--m_ships[shipId].m_hitsLeft == 0);
     }
     // Return true
     return true;
@@ -315,7 +665,13 @@ bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 
 Board::Board(const Game& g)
 {
-    m_impl = new BoardImpl(g);
+    // The standard game gets the board built for it at compile time
+    if (g.rows() == StandardBoard::rows && g.cols() == StandardBoard::cols && hasFleet<StandardFleet>(g))
+        m_impl = new FixedBoardImpl<10, 10, StandardFleet>(g);
+    else if (g.rows() * g.cols() <= MASKCELLS)
+        m_impl = new MaskBoardImpl(g);
+    else
+        m_impl = new SparseBoardImpl(g);
 }
 
 Board::~Board()
@@ -353,6 +709,21 @@ void Board::display(bool shotsOnly) const
     m_impl->display(shotsOnly);
 }
 
+void Board::render(string& frame, bool shotsOnly) const
+{
+    m_impl->render(frame, shotsOnly);
+}
+
+char Board::cellChar(Point p, bool shotsOnly) const
+{
+    return m_impl->cellChar(p.r, p.c, shotsOnly);
+}
+
+Point Board::framePosition(Point p) const
+{
+    return m_impl->framePosition(p);
+}
+
 bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
     return m_impl->attack(p, shotHit, shipDestroyed, shipId);
@@ -2,6 +2,7 @@
 #define BOARD_INCLUDED
 
 #include "globals.h"
+#include <string>
 
 class Game;
 class BoardImpl;
@@ -18,6 +19,9 @@ public:
     bool placeShip(Point topOrLeft, int shipId, Direction dir);
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
     void display(bool shotsOnly) const;
+    void render(std::string& frame, bool shotsOnly) const;
+    char cellChar(Point p, bool shotsOnly) const;
+    Point framePosition(Point p) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
     bool allShipsDestroyed() const;
     // We prevent a Board object from being copied or assigned
@@ -0,0 +1,83 @@
+#ifndef CELLMASK_INCLUDED
+#define CELLMASK_INCLUDED
+
+#include <cstdint>
+
+// Number of cells a CellMask can hold -- boards up to this size are kept as masks
+const int MASKCELLS = 128;
+
+// A set of board cells as a 128-bit mask.  Cell (r, c) of a board with
+// nCols columns is bit r*nCols + c, so a horizontal ship is a run of
+// adjacent bits and a vertical one is a run of bits nCols apart.
+class CellMask
+{
+public:
+    constexpr CellMask() : m_lo(0), m_hi(0) {}
+    constexpr CellMask(std::uint64_t lo, std::uint64_t hi) : m_lo(lo), m_hi(hi) {}
+    
+    // Mask holding only cell i
+    static constexpr CellMask bit(int i)
+    {
+        return i < 64 ? CellMask(std::uint64_t(1) << i, 0) : CellMask(0, std::uint64_t(1) << (i - 64));
+    }
+    // Mask holding cells 0 through n-1
+    static constexpr CellMask firstN(int n)
+    {
+        if (n <= 0)
+            return CellMask();
+        if (n < 64)
+            return CellMask((std::uint64_t(1) << n) - 1, 0);
+        if (n < 128)
+            return CellMask(~std::uint64_t(0), (std::uint64_t(1) << (n - 64)) - 1);
+        return CellMask(~std::uint64_t(0), ~std::uint64_t(0));
+    }
+    
+    constexpr bool test(int i) const { return i < 64 ? (m_lo >> i) & 1 : (m_hi >> (i - 64)) & 1; }
+    constexpr void set(int i) { *this |= bit(i); }
+    constexpr void reset(int i) { *this &= ~bit(i); }
+    constexpr bool any() const { return (m_lo | m_hi) != 0; }
+    constexpr bool none() const { return (m_lo | m_hi) == 0; }
+    int count() const { return __builtin_popcountll(m_lo) + __builtin_popcountll(m_hi); }
+    // Index of the lowest cell in the mask, or -1 if it is empty
+    int lowest() const
+    {
+        if (m_lo != 0)
+            return __builtin_ctzll(m_lo);
+        if (m_hi != 0)
+            return 64 + __builtin_ctzll(m_hi);
+        return -1;
+    }
+    constexpr std::uint64_t lo() const { return m_lo; }
+    constexpr std::uint64_t hi() const { return m_hi; }
+    
+    constexpr CellMask operator<<(int n) const
+    {
+        if (n == 0)
+            return *this;
+        if (n >= 64)
+            return CellMask(0, n >= 128 ? 0 : m_lo << (n - 64));
+        return CellMask(m_lo << n, (m_hi << n) | (m_lo >> (64 - n)));
+    }
+    constexpr CellMask operator>>(int n) const
+    {
+        if (n == 0)
+            return *this;
+        if (n >= 64)
+            return CellMask(n >= 128 ? 0 : m_hi >> (n - 64), 0);
+        return CellMask((m_lo >> n) | (m_hi << (64 - n)), m_hi >> n);
+    }
+    constexpr CellMask operator&(const CellMask& o) const { return CellMask(m_lo & o.m_lo, m_hi & o.m_hi); }
+    constexpr CellMask operator|(const CellMask& o) const { return CellMask(m_lo | o.m_lo, m_hi | o.m_hi); }
+    constexpr CellMask operator^(const CellMask& o) const { return CellMask(m_lo ^ o.m_lo, m_hi ^ o.m_hi); }
+    constexpr CellMask operator~() const { return CellMask(~m_lo, ~m_hi); }
+    constexpr CellMask& operator&=(const CellMask& o) { m_lo &= o.m_lo; m_hi &= o.m_hi; return *this; }
+    constexpr CellMask& operator|=(const CellMask& o) { m_lo |= o.m_lo; m_hi |= o.m_hi; return *this; }
+    constexpr CellMask& operator^=(const CellMask& o) { m_lo ^= o.m_lo; m_hi ^= o.m_hi; return *this; }
+    constexpr bool operator==(const CellMask& o) const { return m_lo == o.m_lo && m_hi == o.m_hi; }
+    constexpr bool operator!=(const CellMask& o) const { return !(*this == o); }
+    
+private:
+    std::uint64_t m_lo, m_hi;
+};
+
+#endif // CELLMASK_INCLUDED
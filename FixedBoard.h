@@ -0,0 +1,134 @@
+#ifndef FIXEDBOARD_INCLUDED
+#define FIXEDBOARD_INCLUDED
+
+#include "CellMask.h"
+#include "Fleet.h"
+#include "globals.h"
+#include <array>
+
+// A board whose geometry and fleet are template parameters.  It follows the
+// rules of Board, but every bound and loop count is a compile-time constant
+// and the mask of every (ship, direction, cell) placement is a constexpr
+// table, so placing a ship is one lookup and one AND.  Board uses it for
+// the standard game and keeps its own representations for the geometries
+// and fleets only known at run time.
+template <int Rows, int Cols, class Fleet = StandardFleet>
+class FixedBoard
+{
+    static_assert(Rows >= 1 && Cols >= 1 && Rows * Cols <= MASKCELLS,
+                  "a FixedBoard must fit in a CellMask");
+public:
+    static constexpr int rows = Rows;
+    static constexpr int cols = Cols;
+    static constexpr int nCells = Rows * Cols;
+    static constexpr int nShips = Fleet::nShips;
+    
+    // Mask of a placement, or an empty mask if the ship would leave the board
+    static constexpr CellMask placement(int shipId, Direction dir, int cell)
+    {
+        return s_placements[(shipId * 2 + dir) * nCells + cell];
+    }
+    
+    void clear() { *this = FixedBoard(); }
+    
+    void block(Rng& rng)
+    {
+        std::uint64_t words[2];
+        rng.fill(words, 2);
+        m_blocked = ~CellMask(words[0], words[1]) & CellMask::firstN(nCells) & ~m_occupied;
+    }
+    
+    void unblock() { m_blocked = CellMask(); }
+    
+    bool placeShip(Point topOrLeft, int shipId, Direction dir)
+    {
+        if (shipId < 0 || shipId >= nShips || !inBounds(topOrLeft))
+            return false;
+        CellMask mask = placement(shipId, dir, topOrLeft.r * Cols + topOrLeft.c);
+        if (mask.none() || m_shipCells[shipId].any() ||
+            (mask & (m_occupied | m_shots | m_blocked)).any())
+            return false;
+        m_occupied |= mask;
+        m_shipCells[shipId] = mask;
+        return true;
+    }
+    
+    bool unplaceShip(Point topOrLeft, int shipId, Direction dir)
+    {
+        if (shipId < 0 || shipId >= nShips || !inBounds(topOrLeft))
+            return false;
+        CellMask mask = placement(shipId, dir, topOrLeft.r * Cols + topOrLeft.c);
+        if (mask.none() || m_shipCells[shipId] != mask || (mask & m_hits).any())
+            return false;
+        m_occupied &= ~mask;
+        m_shipCells[shipId] = CellMask();
+        return true;
+    }
+    
+    bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+    {
+        int i = p.r * Cols + p.c;
+        if (!inBounds(p) || m_shots.test(i) || m_blocked.test(i))
+        {
+            shipId = -1;
+            return false;
+        }
+        m_shots.set(i);
+        shotHit = m_occupied.test(i);
+        shipDestroyed = false;
+        if (shotHit)
+        {
+            m_hits.set(i);
+            for (shipId = 0; !m_shipCells[shipId].test(i); shipId++)
+                ;
+            shipDestroyed = (m_shipCells[shipId] & ~m_hits).none();
+        }
+        return true;
+    }
+    
+    bool allShipsDestroyed() const { return (m_occupied & ~m_hits).none(); }
+    
+    CellMask occupied() const { return m_occupied; }
+    CellMask shots() const { return m_shots; }
+    CellMask hits() const { return m_hits; }
+    CellMask blocked() const { return m_blocked; }
+    CellMask shipCells(int shipId) const { return m_shipCells[shipId]; }
+    
+private:
+    static constexpr bool inBounds(Point p)
+    {
+        return p.r >= 0 && p.r < Rows && p.c >= 0 && p.c < Cols;
+    }
+    
+    static constexpr std::array<CellMask, nShips * 2 * nCells> buildPlacements()
+    {
+        std::array<CellMask, nShips * 2 * nCells> table{};
+        for (int id = 0; id < nShips; id++)
+        {
+            int len = Fleet::ships[id].length;
+            for (int r = 0; r < Rows; r++)
+                for (int c = 0; c < Cols; c++)
+                {
+                    CellMask h, v;
+                    if (c + len <= Cols)
+                        for (int i = 0; i < len; i++)
+                            h.set(r * Cols + c + i);
+                    if (r + len <= Rows)
+                        for (int i = 0; i < len; i++)
+                            v.set((r + i) * Cols + c);
+                    table[(id * 2 + HORIZONTAL) * nCells + r * Cols + c] = h;
+                    table[(id * 2 + VERTICAL) * nCells + r * Cols + c] = v;
+                }
+        }
+        return table;
+    }
+    static constexpr std::array<CellMask, nShips * 2 * nCells> s_placements = buildPlacements();
+    
+    CellMask m_occupied, m_shots, m_hits, m_blocked;
+    std::array<CellMask, nShips> m_shipCells{};
+};
+
+// The standard 10 x 10 game
+typedef FixedBoard<10, 10, StandardFleet> StandardBoard;
+
+#endif // FIXEDBOARD_INCLUDED
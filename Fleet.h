@@ -0,0 +1,49 @@
+#ifndef FLEET_INCLUDED
+#define FLEET_INCLUDED
+
+#include "Game.h"
+
+// One ship of a compile-time fleet description
+struct ShipSpec
+{
+    int length;
+    char symbol;
+    const char* name;
+};
+
+// The fleet of the standard game -- the ships addStandardShips adds
+struct StandardFleet
+{
+    static constexpr int nShips = 5;
+    static constexpr ShipSpec ships[nShips] = {
+        { 5, 'A', "aircraft carrier" },
+        { 4, 'B', "battleship" },
+        { 3, 'D', "destroyer" },
+        { 3, 'S', "submarine" },
+        { 2, 'P', "patrol boat" }
+    };
+};
+
+// Add every ship of a compile-time fleet to a runtime Game
+template <class Fleet>
+bool addFleet(Game& g)
+{
+    for (int k = 0; k < Fleet::nShips; k++)
+        if (!g.addShip(Fleet::ships[k].length, Fleet::ships[k].symbol, Fleet::ships[k].name))
+            return false;
+    return true;
+}
+
+// Whether a runtime Game has exactly the ships of a compile-time fleet, in order
+template <class Fleet>
+bool hasFleet(const Game& g)
+{
+    if (g.nShips() != Fleet::nShips)
+        return false;
+    for (int k = 0; k < Fleet::nShips; k++)
+        if (g.shipLength(k) != Fleet::ships[k].length)
+            return false;
+    return true;
+}
+
+#endif // FLEET_INCLUDED
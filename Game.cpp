@@ -1,8 +1,12 @@
 #include "Game.h"
 #include "Board.h"
 #include "Player.h"
+#include "GameObserver.h"
+#include "Instrument.h"
+#include "PlacementTable.h"
 #include "globals.h"
 #include <iostream>
+#include <memory>
 #include <string>
 #include <cstdlib>
 #include <cctype>
@@ -20,23 +24,24 @@ class GameImpl
 {
 public:
     // Constructor
-    GameImpl(int nRows, int nCols) : m_rows(nRows), m_cols(nCols), m_nShips(0), m_ships({}) {}
-    // Destructor
-    ~GameImpl();
+    GameImpl(int nRows, int nCols) : m_rows(nRows), m_cols(nCols), m_nShips(0), m_ships({}), m_rng(threadRng().next()) {}
     
     // Accessors
     int rows() const { return m_rows; }
     int cols() const { return m_cols; }
     int nShips() const { return m_nShips; }
-    int shipLength(int shipId) const { return m_ships[shipId]->m_len; }
-    char shipSymbol(int shipId) const { return m_ships[shipId]->m_symbol; }
-    string shipName(int shipId) const { return m_ships[shipId]->m_name; }
+    int shipLength(int shipId) const { return m_ships[shipId].m_len; }
+    char shipSymbol(int shipId) const { return m_ships[shipId].m_symbol; }
+    const string& shipName(int shipId) const { return m_ships[shipId].m_name; }
+    const shared_ptr<const PlacementTable>& placements() const;
     
     // Other
     bool addShip(int length, char symbol, string name);
     bool isValid(Point p) const { return p.r >= 0  &&  p.r < rows()  &&  p.c >= 0  &&  p.c < cols(); }
-    Point randomPoint() const { return Point(randInt(rows()), randInt(cols())); }
-    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+    Point randomPoint() const { return Point(m_rng.randInt(rows()), m_rng.randInt(cols())); }
+    Rng& rng() const { return m_rng; }
+    void seed(uint64_t s) { m_rng.reseed(s); }
+    Board& board(const Game& g, int i);
     
 private:
     int m_rows, m_cols, m_nShips;
@@ -49,24 +54,17 @@ private:
         char m_symbol;
         string m_name;
     };
-    // Store ships using a vector of Ship pointers
+    // Ships are stored contiguously by value
     // Ships vector index corresponds to its id
-    // Using pointers saves memory and allows it to run faster because it does not have to duplicate values
-    vector<Ship*> m_ships;
+    vector<Ship> m_ships;
+    // Every random decision of this game's boards and players draws from here
+    mutable Rng m_rng;
+    // Placement table of this geometry -- fetched on first use, dropped when a ship is added
+    mutable shared_ptr<const PlacementTable> m_placements;
+    // The two boards of play -- built by the first game, cleared for each later one
+    unique_ptr<Board> m_boards[2];
 };
 
-/**
-    Destructor
- 
-    Since pointers are used in the private members the destructor must explicitly delete them
-    Implemented using a range based for loop
- */
-GameImpl::~GameImpl()
-{
-    for (auto d : m_ships)
-        delete d;
-}
-
 /**
     Adds new ship to storage and returns true
  
@@ -77,110 +75,221 @@ GameImpl::~GameImpl()
  */
 bool GameImpl::addShip(int length, char symbol, string name)
 {
-    Ship* new_ship = new Ship(m_nShips++, length, symbol, name);
-    m_ships.push_back(new_ship);
+    m_ships.push_back(Ship(m_nShips++, length, symbol, name));
+    m_placements.reset();
+    // Boards are sized for the fleet, so they have to be built anew
+    m_boards[0].reset();
+    m_boards[1].reset();
     return true;
 }
 
 /**
-    Runs a complete game between two indicated players
+    Returns the placement table of this board size and fleet
+ 
+    @return The table, shared with every other game of the same geometry
+    Fetched once the fleet is complete -- the first call after the last addShip
+ */
+const shared_ptr<const PlacementTable>& GameImpl::placements() const
+{
+    if (m_placements == nullptr)
+    {
+        vector<int> lengths;
+        for (const Ship& s : m_ships)
+            lengths.push_back(s.m_len);
+        m_placements = PlacementTable::get(m_rows, m_cols, lengths);
+    }
+    return m_placements;
+}
+
+/**
+    Returns one of the boards of play, cleared
+ 
+    @param1 g The game that owns this GameImpl
+    @param2 i Which board -- 0 or 1
+    @return The board, built on first use and reused by every later game
+ */
+Board& GameImpl::board(const Game& g, int i)
+{
+    if (m_boards[i] == nullptr)
+        m_boards[i].reset(new Board(g));
+    else
+        m_boards[i]->clear();
+    return *m_boards[i];
+}
+
+//*********************************************************************
+//  GameRun
+//*********************************************************************
+
+/**
+    GameRun constructor
+ 
+    @param1 g The game to play -- its fleet must be complete before start is called
+    Both players are internal until setExternal says otherwise
+ */
+GameRun::GameRun(Game& g)
+: m_game(g), m_observer(nullptr), m_announced(false), m_turn(0), m_state(NOT_STARTED)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        m_players[i] = nullptr;
+        m_boards[i] = nullptr;
+        m_external[i] = false;
+    }
+}
+
+/**
+    Sets up a game between two indicated players, ready for its first turn
  
     @param1 p1 Pointer to the first player -- either human, awful, mediocre, or good
     @param2 p2 Pointer to the second player -- either human, awful, mediocre, or good
-    @param3 b1 Reference to first players board
-    @param4 b2 Reference to second players board
-    @param5 shouldPause If true program will wait for user to press enter before continuing to subsequent turns
-    @return Pointer to the winning player -- either p1 or p2
+    @param3 observer Receives the turn events -- if nullptr the game runs headless and does no output at all
+    p1 places its ships first and moves first, each on a cleared board of the game
+    @return False if there are no players or ships, both players are human, or the ships could not be placed
  */
-Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause)
+bool GameRun::start(Player* p1, Player* p2, GameObserver* observer)
 {
-    // Player points and board pointer
-    Player *t1, *t2;
-    Board* b;
-    // P1s turn is first
-    bool p1Turn = true;
-    bool human;
-    
+    m_state = NOT_STARTED;
+    if (p1 == nullptr  ||  p2 == nullptr  ||  m_game.nShips() == 0)
+        return false;
     // Check to make sure both players are not human
     if (p1->isHuman() && p2->isHuman())
     {
         cout << "This game does not support 2-player." << endl;
-        return nullptr;
+        return false;
     }
-    // If ships cannot be placed return nullptr
-    if (!p1->placeShips(b1)) return nullptr;
-    if (!p2->placeShips(b2)) return nullptr;
-    
-    // Play game until one of the players ships are destroyed
-    while (!b1.allShipsDestroyed() && !b2.allShipsDestroyed())
+    m_players[0] = p1;
+    m_players[1] = p2;
+    m_boards[0] = &m_game.m_impl->board(m_game, 0);
+    m_boards[1] = &m_game.m_impl->board(m_game, 1);
+    m_observer = observer;
+    m_announced = false;
+    m_turn = 0;
+    // If ships cannot be placed the game does not start
+    if (!instrumentTimed(*p1, LATENCY_PLACESHIPS, [&] { return p1->placeShips(*m_boards[0]); })) return false;
+    if (!instrumentTimed(*p2, LATENCY_PLACESHIPS, [&] { return p2->placeShips(*m_boards[1]); })) return false;
+    m_state = READY;
+    return true;
+}
+
+/**
+    Plays the next turn, unless its attacker is external
+ 
+    An external attacker's turn is announced and left waiting for move
+    @return The state the game is left in
+ */
+GameRun::State GameRun::step()
+{
+    if (m_state != READY)
+        return m_state;
+    announce();
+    Player* t1 = m_players[attacker()];
+    if (m_external[attacker()])
     {
-        // Set booleans to false
-        bool shotHit = false, shipDestroyed = false, validShot = false;
-        // Garbage value
-        int shipId = 100;
-        // Set pointer variables depending on whos turn it is
-        if (p1Turn)
-        {
-            t1 = p1;
-            t2 = p2;
-            b = &b2;
-            human = p1->isHuman();
-        }
-        else
-        {
-            t1 = p2;
-            t2 = p1;
-            b = &b1;
-            human = p2->isHuman();
-        }
-        // Display board
-        cout << t1->name() << "'s turn. Board for " << t2->name() << ":" << endl;
-        b->display(human);
-        // Get attack from player
-        Point attackCoord = t1->recommendAttack();
-        // Attack and set validShot to result
-        validShot = b->attack(attackCoord, shotHit, shipDestroyed, shipId);
-        // Record the attack result
-        t1->recordAttackResult(attackCoord, validShot, shotHit, shipDestroyed, shipId);
-        // If human and shot was invalid print special message
-        // Computers cannot waste shots
-        if (human && shipId == -1)
-            cout << t1->name() << " wasted a shot at (" << attackCoord.r << "," << attackCoord.c << ")." << endl;
-        // Shot is valid
-        else
-        {
-            // Display message depending on result of attack
-            cout << t1->name() << " attacked (" << attackCoord.r << "," << attackCoord.c << ") and ";
-            if (shotHit && shipDestroyed)
-                cout << "destroyed the " << this->shipName(shipId);
-            else if (shotHit)
-                cout << "hit something";
-            else
-                cout << "missed";
-            cout << ", resulting in:" << endl;
-            // Display results -- board displayed depends on whether the player is a human or not
-            b->display(human);
-        }
-        // Switch turn to P2
-        p1Turn = !p1Turn;
-        
-        // If one of the player's ships are destroyed break loop
-        if (b1.allShipsDestroyed() || b2.allShipsDestroyed())
-            break;
-        // If pause parameter is true waitForEnter after each turn
-        if (shouldPause)
-            waitForEnter();
+        m_state = AWAITING_MOVE;
+        return m_state;
     }
+    // Get attack from player
+    Point attackCoord = instrumentTimed(*t1, LATENCY_RECOMMENDATTACK,
+                                        [&] { return t1->recommendAttack(); });
+    finishTurn(attackCoord);
+    return m_state;
+}
 
-    // Set t1 to the winnder
-    if (b1.allShipsDestroyed())
-        t1 = p2;
-    else
-        t1 = p1;
+/**
+    Plays the waiting turn of an external attacker
+ 
+    @param1 p Where the attacker shoots
+    @return The state the game is left in -- unchanged unless it was AWAITING_MOVE
+ */
+GameRun::State GameRun::move(Point p)
+{
+    if (m_state != AWAITING_MOVE)
+        return m_state;
+    finishTurn(p);
+    return m_state;
+}
+
+/**
+    Plays turns until the game is over or waits for an external attacker
+ 
+    @return The state the game is left in
+ */
+GameRun::State GameRun::resume()
+{
+    while (step() == READY)
+        ;
+    return m_state;
+}
+
+/**
+    Returns the winner
+ 
+    @return The player whose opponent lost every ship -- nullptr until the game is over
+ */
+Player* GameRun::winner() const
+{
+    if (m_state != OVER)
+        return nullptr;
+    return m_boards[0]->allShipsDestroyed() ? m_players[1] : m_players[0];
+}
+
+/**
+    Tells the observer whose turn it is, once per turn
+ */
+void GameRun::announce()
+{
+    if (m_announced)
+        return;
+    m_announced = true;
+    // Show the board -- humans only get to see the shots
+    int a = attacker();
+    if (m_observer != nullptr)
+        m_observer->turnStarted(*m_players[a], *m_players[1 - a], *m_boards[1 - a],
+                                m_players[a]->isHuman());
+}
+
+/**
+    Fires the attacker's shot, reports it, and passes the turn
+ 
+    @param1 p Point attacked
+ */
+void GameRun::finishTurn(Point p)
+{
+    int a = attacker();
+    Player* t1 = m_players[a];
+    Board* b = m_boards[1 - a];
+    bool human = t1->isHuman();
+    // Set booleans to false
+    bool shotHit = false, shipDestroyed = false, validShot = false;
+    // Garbage value
+    int shipId = 100;
+    // Attack and set validShot to result
+    validShot = b->attack(p, shotHit, shipDestroyed, shipId);
+    if (!validShot)
+        instrumentCount(*t1, COUNT_INVALIDSHOTS);
+    // Record the attack result
+    instrumentTimed(*t1, LATENCY_RECORDATTACKRESULT, [&]
+    {
+        t1->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+    });
+    // Report the result of the attack
+    if (m_observer != nullptr)
+        m_observer->attackMade(*t1, p, validShot, shotHit, shipDestroyed, shipId, *b, human);
+    // Switch turn to the other player
+    m_turn++;
+    m_announced = false;
     
-    // Output name and return winner
-    cout << t1->name() << " wins!" << endl;
-    return t1;
+    // If one of the player's ships are destroyed the game is over
+    if (m_boards[0]->allShipsDestroyed() || m_boards[1]->allShipsDestroyed())
+    {
+        m_state = OVER;
+        // Report the winner
+        if (m_observer != nullptr)
+            m_observer->gameWon(*winner());
+    }
+    else
+        m_state = READY;
 }
 
 //******************** Game functions *******************************
@@ -200,6 +309,8 @@ Game::Game(int nRows, int nCols)
         cout << "Number of columns must be >= 1 and <= " << MAXCOLS << endl;
         exit(1);
     }
+    m_rows = nRows;
+    m_cols = nCols;
     m_impl = new GameImpl(nRows, nCols);
 }
 
@@ -208,24 +319,24 @@ Game::~Game()
     delete m_impl;
 }
 
-int Game::rows() const
+bool Game::isValid(Point p) const
 {
-    return m_impl->rows();
+    return m_impl->isValid(p);
 }
 
-int Game::cols() const
+Point Game::randomPoint() const
 {
-    return m_impl->cols();
+    return m_impl->randomPoint();
 }
 
-bool Game::isValid(Point p) const
+Rng& Game::rng() const
 {
-    return m_impl->isValid(p);
+    return m_impl->rng();
 }
 
-Point Game::randomPoint() const
+void Game::seed(uint64_t s)
 {
-    return m_impl->randomPoint();
+    m_impl->seed(s);
 }
 
 bool Game::addShip(int length, char symbol, string name)
@@ -289,17 +400,41 @@ char Game::shipSymbol(int shipId) const
     return m_impl->shipSymbol(shipId);
 }
 
-string Game::shipName(int shipId) const
+const string& Game::shipName(int shipId) const
 {
     assert(shipId >= 0  &&  shipId < nShips());
     return m_impl->shipName(shipId);
 }
 
+const shared_ptr<const PlacementTable>& Game::placements() const
+{
+    return m_impl->placements();
+}
+
 Player* Game::play(Player* p1, Player* p2, bool shouldPause)
 {
-    if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
+    // Each game draws with its own observer -- the frame buffer is per game
+    ConsoleObserver console;
+    return play(p1, p2, &console, shouldPause);
+}
+
+/**
+    Runs a complete game between two indicated players
+ 
+    @param1 p1 Pointer to the first player -- it places its ships and moves first
+    @param2 p2 Pointer to the second player
+    @param3 observer Receives the turn events -- if nullptr the game runs headless and does no output at all
+    @param4 shouldPause If true program will wait for user to press enter before continuing to subsequent turns
+    @return Pointer to the winning player, or nullptr if the game could not be played
+ */
+Player* Game::play(Player* p1, Player* p2, GameObserver* observer, bool shouldPause)
+{
+    GameRun run(*this);
+    if (!run.start(p1, p2, observer))
         return nullptr;
-    Board b1(*this);
-    Board b2(*this);
-    return m_impl->play(p1, p2, b1, b2, shouldPause);
+    // Every player is internal, so a turn only stops the run to pause
+    while (run.step() == GameRun::READY)
+        if (shouldPause)
+            waitForEnter();
+    return run.winner();
 }
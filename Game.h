@@ -3,32 +3,92 @@
 
 #include <string>
 #include <cassert>
+#include <cstdint>
+#include <memory>
 
+class Board;
 class Point;
 class Player;
 class GameImpl;
+class GameObserver;
+class Rng;
+class PlacementTable;
 
 class Game
 {
 public:
     Game(int nRows, int nCols);
     ~Game();
-    int rows() const;
-    int cols() const;
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
     bool isValid(Point p) const;
     Point randomPoint() const;
+    Rng& rng() const;
+    void seed(std::uint64_t s);
     bool addShip(int length, char symbol, std::string name);
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
-    std::string shipName(int shipId) const;
+    const std::string& shipName(int shipId) const;
+    const std::shared_ptr<const PlacementTable>& placements() const;
     Player* play(Player* p1, Player* p2, bool shouldPause = true);
+    Player* play(Player* p1, Player* p2, GameObserver* observer, bool shouldPause = false);
     // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
     
 private:
+    friend class GameRun;
+    // Cached here so the most frequent queries need not go through m_impl
+    int m_rows, m_cols;
     GameImpl* m_impl;
 };
 
+// A game played a turn at a time.  Game::play runs a whole game before it
+// returns; a GameRun instead stops wherever its driver likes, and whenever
+// the player to move is external -- its moves come from outside, e.g. a
+// client on a socket or a search on another thread -- until move supplies
+// the shot.  One thread can so keep many games going at once.  A run is
+// only a few pointers and flags, and plays on the game's own boards, so
+// parking and resuming a game costs nothing.
+class GameRun
+{
+public:
+    enum State {
+        NOT_STARTED,    // start has not been called, or failed
+        READY,          // step will play the next turn
+        AWAITING_MOVE,  // the attacker is external and move must be called
+        OVER            // somebody won
+    };
+    GameRun(Game& g);
+    bool start(Player* p1, Player* p2, GameObserver* observer = nullptr);
+    void setExternal(int player, bool external) { m_external[player] = external; }
+    State state() const { return m_state; }
+    State step();
+    State move(Point p);
+    State resume();
+    long turn() const { return m_turn; }
+    int attacker() const { return static_cast<int>(m_turn & 1); }
+    Player* player(int i) const { return m_players[i]; }
+    const Board& board(int i) const { return *m_boards[i]; }
+    Player* winner() const;
+    // We prevent a GameRun object from being copied or assigned
+    GameRun(const GameRun&) = delete;
+    GameRun& operator=(const GameRun&) = delete;
+    
+private:
+    void announce();
+    void finishTurn(Point p);
+    
+    Game& m_game;
+    Player* m_players[2];
+    Board* m_boards[2];
+    GameObserver* m_observer;
+    bool m_external[2];
+    // True once turnStarted has gone out for the current turn
+    bool m_announced;
+    long m_turn;
+    State m_state;
+};
+
 #endif // GAME_INCLUDED
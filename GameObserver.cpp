@@ -0,0 +1,261 @@
+#include "GameObserver.h"
+#include "Board.h"
+#include "Game.h"
+#include "Player.h"
+#include "globals.h"
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// ANSI sequences: home the cursor and clear the screen, and clear to its end
+static const char CLEARSCREEN[] = "\x1b[H\x1b[2J";
+static const char CLEARBELOW[] = "\x1b[J";
+
+/**
+    Appends what an attack did, e.g. "Bluto attacked (3,4) and missed"
+ 
+    @param1 out Where the text goes -- no newline is added
+    Remaining parameters are those of attackMade
+ */
+static void describeAttack(string& out, const Player& attacker, Point p, bool validShot,
+                           bool shotHit, bool shipDestroyed, int shipId)
+{
+    out += attacker.name();
+    // Computers cannot waste shots, so only humans get the special message
+    if (attacker.isHuman() && !validShot)
+        out += " wasted a shot at (";
+    else
+        out += " attacked (";
+    out += to_string(p.r);
+    out += ',';
+    out += to_string(p.c);
+    out += ')';
+    if (attacker.isHuman() && !validShot)
+        out += '.';
+    else if (shotHit && shipDestroyed)
+    {
+        out += " and destroyed the ";
+        out += attacker.game().shipName(shipId);
+    }
+    else if (shotHit)
+        out += " and hit something";
+    else
+        out += " and missed";
+}
+
+/**
+    ConsoleObserver constructor
+ 
+    @param1 incremental True to redraw boards in place instead of writing a transcript
+ */
+ConsoleObserver::ConsoleObserver(bool incremental)
+: m_incremental(incremental), m_nRegions(0), m_statusLine(1)
+{}
+
+/**
+    Announces whose turn it is and shows the board being attacked
+ 
+    @param1 attacker The player about to shoot
+    @param2 defender The player whose board is shot at
+    @param3 b The defender's board
+    @param4 shotsOnly True if ship segments must be hidden -- i.e. a human is attacking
+ */
+void ConsoleObserver::turnStarted(const Player& attacker, const Player& defender,
+                                  const Board& b, bool shotsOnly)
+{
+    m_buffer.clear();
+    if (m_incremental)
+    {
+        placeBoard(defender, b, shotsOnly);
+        beginStatus();
+        m_buffer += attacker.name();
+        m_buffer += "'s turn\n";
+    }
+    else
+    {
+        m_buffer += attacker.name();
+        m_buffer += "'s turn. Board for ";
+        m_buffer += defender.name();
+        m_buffer += ":\n";
+        b.render(m_buffer, shotsOnly);
+    }
+    write();
+}
+
+/**
+    Reports the result of an attack and shows the resulting board
+ 
+    @param1 attacker The player who shot
+    @param2 p The point attacked
+    @param3 validShot True if the shot was in bounds and not already taken
+    @param4 shotHit True if the shot hit a ship
+    @param5 shipDestroyed True if the shot destroyed a ship
+    @param6 shipId Id of the ship hit, -1 if the shot was invalid
+    @param7 b The board that was attacked
+    @param8 shotsOnly True if ship segments must be hidden -- i.e. a human is attacking
+ */
+void ConsoleObserver::attackMade(const Player& attacker, Point p, bool validShot,
+                                 bool shotHit, bool shipDestroyed, int shipId,
+                                 const Board& b, bool shotsOnly)
+{
+    m_buffer.clear();
+    if (m_incremental)
+    {
+        // Only the attacked cell can have changed -- a valid shot marks just that cell
+        const Region* region = nullptr;
+        for (int i = 0; i < m_nRegions; i++)
+            if (m_regions[i].board == &b && m_regions[i].shotsOnly == shotsOnly)
+                region = &m_regions[i];
+        if (region != nullptr && validShot)
+        {
+            Point pos = b.framePosition(p);
+            moveTo(region->top + 1 + pos.r, 1 + pos.c);
+            m_buffer += b.cellChar(p, shotsOnly);
+        }
+        beginStatus();
+        describeAttack(m_buffer, attacker, p, validShot, shotHit, shipDestroyed, shipId);
+        m_buffer += '\n';
+    }
+    else
+    {
+        describeAttack(m_buffer, attacker, p, validShot, shotHit, shipDestroyed, shipId);
+        // A wasted shot changes nothing, so the board is not shown again
+        if (attacker.isHuman() && !validShot)
+            m_buffer += '\n';
+        else
+        {
+            m_buffer += ", resulting in:\n";
+            b.render(m_buffer, shotsOnly);
+        }
+    }
+    write();
+}
+
+/**
+    Announces the winner
+ 
+    @param1 winner The player who won
+ */
+void ConsoleObserver::gameWon(const Player& winner)
+{
+    m_buffer.clear();
+    if (m_incremental)
+    {
+        beginStatus();
+        // The next game starts on a clean screen
+        m_nRegions = 0;
+    }
+    m_buffer += winner.name();
+    m_buffer += " wins!\n";
+    write();
+}
+
+/**
+    Makes sure a board is drawn, drawing it in full if it is not
+ 
+    @param1 defender The board's owner, named in its title
+    @param2 b The board
+    @param3 shotsOnly True if ship segments must be hidden
+    A third board means a new game, which starts over on a clean screen
+    @return Where the board is drawn
+ */
+const ConsoleObserver::Region* ConsoleObserver::placeBoard(const Player& defender, const Board& b,
+                                                           bool shotsOnly)
+{
+    Region* region = nullptr;
+    for (int i = 0; i < m_nRegions; i++)
+        if (m_regions[i].board == &b)
+            region = &m_regions[i];
+    if (region != nullptr && region->shotsOnly == shotsOnly)
+        return region;
+    bool isNew = (region == nullptr);
+    if (isNew)
+    {
+        if (m_nRegions == 2)
+            m_nRegions = 0;
+        if (m_nRegions == 0)
+        {
+            m_buffer += CLEARSCREEN;
+            m_statusLine = 1;
+        }
+        // Boards are stacked, a blank line apart
+        region = &m_regions[m_nRegions++];
+        region->board = &b;
+        region->top = (m_nRegions == 1 ? 1 : m_regions[0].top + m_regions[0].height + 1);
+        region->height = 1 + b.framePosition(Point(defender.game().rows() - 1, 0)).r + 1;
+        m_statusLine = region->top + region->height + 1;
+    }
+    // A new board goes below the others, over the old status -- a board drawn again
+    // has the same shape as before, so drawing over it leaves nothing behind
+    moveTo(region->top, 1);
+    if (isNew)
+        m_buffer += CLEARBELOW;
+    region->shotsOnly = shotsOnly;
+    m_buffer += "Board for ";
+    m_buffer += defender.name();
+    m_buffer += ":\n";
+    b.render(m_buffer, shotsOnly);
+    return region;
+}
+
+/**
+    Appends the sequence that moves the cursor
+ 
+    @param1 line Terminal line, counting from 1
+    @param2 column Terminal column, counting from 1
+ */
+void ConsoleObserver::moveTo(int line, int column)
+{
+    m_buffer += "\x1b[";
+    m_buffer += to_string(line);
+    m_buffer += ';';
+    m_buffer += to_string(column);
+    m_buffer += 'H';
+}
+
+/**
+    Moves to the status line and clears it and everything below
+    The caller appends the new status, which stays until the next event
+ */
+void ConsoleObserver::beginStatus()
+{
+    moveTo(m_statusLine, 1);
+    m_buffer += CLEARBELOW;
+}
+
+/**
+    Writes the buffered event with one call
+    In incremental mode it is also flushed, so the screen keeps up with the game
+ */
+void ConsoleObserver::write()
+{
+    cout.write(m_buffer.data(), m_buffer.size());
+    if (m_incremental)
+        cout.flush();
+}
+
+//*********************************************************************
+//  TeeObserver
+//*********************************************************************
+
+void TeeObserver::turnStarted(const Player& attacker, const Player& defender,
+                              const Board& b, bool shotsOnly)
+{
+    m_first.turnStarted(attacker, defender, b, shotsOnly);
+    m_second.turnStarted(attacker, defender, b, shotsOnly);
+}
+
+void TeeObserver::attackMade(const Player& attacker, Point p, bool validShot,
+                             bool shotHit, bool shipDestroyed, int shipId,
+                             const Board& b, bool shotsOnly)
+{
+    m_first.attackMade(attacker, p, validShot, shotHit, shipDestroyed, shipId, b, shotsOnly);
+    m_second.attackMade(attacker, p, validShot, shotHit, shipDestroyed, shipId, b, shotsOnly);
+}
+
+void TeeObserver::gameWon(const Player& winner)
+{
+    m_first.gameWon(winner);
+    m_second.gameWon(winner);
+}
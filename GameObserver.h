@@ -0,0 +1,82 @@
+#ifndef GAMEOBSERVER_INCLUDED
+#define GAMEOBSERVER_INCLUDED
+
+#include "globals.h"
+#include <string>
+
+class Board;
+class Player;
+
+// Receives the turn events of a game as GameImpl::play runs it.  Every
+// callback has an empty default so a sink only overrides what it needs.
+class GameObserver
+{
+public:
+    virtual ~GameObserver() {}
+    
+    virtual void turnStarted(const Player& /* attacker */, const Player& /* defender */,
+                             const Board& /* b */, bool /* shotsOnly */) {}
+    virtual void attackMade(const Player& /* attacker */, Point /* p */, bool /* validShot */,
+                            bool /* shotHit */, bool /* shipDestroyed */, int /* shipId */,
+                            const Board& /* b */, bool /* shotsOnly */) {}
+    virtual void gameWon(const Player& /* winner */) {}
+};
+
+// Writes the game to cout.  By default that is the traditional turn-by-turn
+// transcript.  In incremental mode both boards are drawn once per game at
+// fixed places on the terminal, and each attack only redraws the cell it
+// changed and a status line, using ANSI cursor addressing -- the boards
+// must fit on the screen, and a human player's prompts would break it.
+// Every event is built in a reused buffer and written with one call.
+class ConsoleObserver : public GameObserver
+{
+public:
+    ConsoleObserver(bool incremental = false);
+    virtual void turnStarted(const Player& attacker, const Player& defender,
+                             const Board& b, bool shotsOnly);
+    virtual void attackMade(const Player& attacker, Point p, bool validShot,
+                            bool shotHit, bool shipDestroyed, int shipId,
+                            const Board& b, bool shotsOnly);
+    virtual void gameWon(const Player& winner);
+    
+private:
+    // Where a board is drawn -- top is the terminal line of its title
+    struct Region
+    {
+        const Board* board;
+        int top;
+        int height;
+        bool shotsOnly;
+    };
+    const Region* placeBoard(const Player& defender, const Board& b, bool shotsOnly);
+    void moveTo(int line, int column);
+    void beginStatus();
+    void write();
+    
+    bool m_incremental;
+    std::string m_buffer;
+    Region m_regions[2];
+    int m_nRegions;
+    // Terminal line just below the boards
+    int m_statusLine;
+};
+
+// Passes every event on to two observers, e.g. a recorder and a logger
+class TeeObserver : public GameObserver
+{
+public:
+    TeeObserver(GameObserver& first, GameObserver& second) : m_first(first), m_second(second) {}
+
+    virtual void turnStarted(const Player& attacker, const Player& defender,
+                             const Board& b, bool shotsOnly);
+    virtual void attackMade(const Player& attacker, Point p, bool validShot,
+                            bool shotHit, bool shipDestroyed, int shipId,
+                            const Board& b, bool shotsOnly);
+    virtual void gameWon(const Player& winner);
+
+private:
+    GameObserver& m_first;
+    GameObserver& m_second;
+};
+
+#endif // GAMEOBSERVER_INCLUDED
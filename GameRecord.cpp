@@ -0,0 +1,390 @@
+#include "GameRecord.h"
+#include "Game.h"
+#include "Player.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const char RECORDMAGIC[8] = { 'B', 'S', 'H', 'I', 'P', 'R', 'E', 'C' };
+const uint32_t RECORDVERSION = 1;
+const size_t FILEHEADERBYTES = 16;
+const size_t RECORDHEADERBYTES = 32;
+const size_t FLUSHBYTES = 1 << 20;
+
+// Number of bits needed to hold every value from 0 to n-1
+static int bitsFor(long n)
+{
+    int bits = 0;
+    while ((1L << bits) < n)
+        bits++;
+    return bits;
+}
+
+static void put8(vector<unsigned char>& v, size_t at, unsigned x)
+{
+    v[at] = static_cast<unsigned char>(x);
+}
+
+static void put16(vector<unsigned char>& v, size_t at, unsigned x)
+{
+    put8(v, at, x & 0xff);
+    put8(v, at + 1, (x >> 8) & 0xff);
+}
+
+static void put32(vector<unsigned char>& v, size_t at, uint32_t x)
+{
+    put16(v, at, x & 0xffff);
+    put16(v, at + 2, x >> 16);
+}
+
+static void put64(vector<unsigned char>& v, size_t at, uint64_t x)
+{
+    put32(v, at, static_cast<uint32_t>(x));
+    put32(v, at + 4, static_cast<uint32_t>(x >> 32));
+}
+
+static void putString(vector<unsigned char>& v, const string& s, size_t maxLen)
+{
+    size_t n = min(s.size(), maxLen);
+    v.insert(v.end(), s.begin(), s.begin() + n);
+}
+
+//*********************************************************************
+//  GameRecordWriter
+//*********************************************************************
+
+/**
+    GameRecordWriter constructor
+ 
+    @param1 path File to write -- it is truncated, then given the file header
+    Use isOpen to learn whether the file could be created
+ */
+GameRecordWriter::GameRecordWriter(const string& path)
+: m_file(path, ios::binary | ios::trunc)
+{
+    if (!m_file)
+        return;
+    m_buffer.reserve(FLUSHBYTES + FLUSHBYTES / 4);
+    m_buffer.assign(RECORDMAGIC, RECORDMAGIC + 8);
+    m_buffer.resize(FILEHEADERBYTES, 0);
+    put32(m_buffer, 8, RECORDVERSION);
+}
+
+GameRecordWriter::~GameRecordWriter()
+{
+    flush();
+}
+
+/**
+    Appends one finished record
+ 
+    @param1 record The encoded record
+    @param2 nBytes Size of the record in bytes
+    Safe to call from several threads at once
+ */
+void GameRecordWriter::write(const unsigned char* record, size_t nBytes)
+{
+    lock_guard<mutex> guard(m_lock);
+    if (!m_file)
+        return;
+    m_buffer.insert(m_buffer.end(), record, record + nBytes);
+    if (m_buffer.size() >= FLUSHBYTES)
+        flushLocked();
+}
+
+/**
+    Writes every buffered record to the file
+ */
+void GameRecordWriter::flush()
+{
+    lock_guard<mutex> guard(m_lock);
+    flushLocked();
+}
+
+void GameRecordWriter::flushLocked()
+{
+    if (!m_file)
+        return;
+    m_file.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+    m_file.flush();
+    m_buffer.clear();
+}
+
+//*********************************************************************
+//  GameRecorder
+//*********************************************************************
+
+/**
+    GameRecorder constructor
+ 
+    @param1 out Writer that receives each finished record
+ */
+GameRecorder::GameRecorder(GameRecordWriter& out)
+: m_out(out), m_rows(0), m_cols(0), m_cellBits(0), m_shotBits(0), m_shotsAt(0), m_nShots(0),
+  m_firstMover(0), m_winner(-1), m_inGame(false)
+{
+    m_players[0] = m_players[1] = nullptr;
+}
+
+GameRecorder::~GameRecorder()
+{
+    endGame();
+}
+
+/**
+    Starts the record of a game that is about to be played
+ 
+    @param1 g The game, with its fleet already added
+    @param2 seed The seed the game was given
+    @param3 p0 The player created first
+    @param4 type0 Its player type, as accepted by createPlayer
+    @param5 p1 The player created second
+    @param6 type1 Its player type
+    A record still open from the previous game is finished first
+ */
+void GameRecorder::beginGame(const Game& g, uint64_t seed,
+                             const Player& p0, const string& type0,
+                             const Player& p1, const string& type1)
+{
+    endGame();
+    m_players[0] = &p0;
+    m_players[1] = &p1;
+    m_rows = g.rows();
+    m_cols = g.cols();
+    m_cellBits = max(bitsFor(static_cast<long>(m_rows) * m_cols), 1);
+    m_shotBits = m_cellBits + 2 + bitsFor(g.nShips());
+    m_nShots = 0;
+    m_firstMover = 0;
+    m_winner = -1;
+    m_inGame = true;
+    
+    // Fixed header and ship table -- the counts are filled in by endGame
+    int nShips = g.nShips();
+    m_record.assign(RECORDHEADERBYTES + 8 * nShips, 0);
+    put16(m_record, 4, m_rows);
+    put16(m_record, 6, m_cols);
+    put64(m_record, 8, seed);
+    put16(m_record, 20, nShips);
+    put8(m_record, 24, m_cellBits);
+    put8(m_record, 25, m_shotBits - m_cellBits - 2);
+    for (int i = 0; i < nShips; i++)
+    {
+        size_t entry = RECORDHEADERBYTES + 8 * i;
+        const string& name = g.shipName(i);
+        put16(m_record, entry, g.shipLength(i));
+        put8(m_record, entry + 2, static_cast<unsigned char>(g.shipSymbol(i)));
+        put8(m_record, entry + 3, min<size_t>(name.size(), 255));
+        put32(m_record, entry + 4, static_cast<uint32_t>(m_record.size()));
+        putString(m_record, name, 255);
+    }
+    put8(m_record, 26, min<size_t>(type0.size(), 255));
+    put8(m_record, 27, min<size_t>(type1.size(), 255));
+    putString(m_record, type0, 255);
+    putString(m_record, type1, 255);
+    m_shotsAt = m_record.size();
+    put32(m_record, 28, static_cast<uint32_t>(m_shotsAt));
+}
+
+/**
+    Finishes the record and hands it to the writer
+ 
+    Called by gameWon, so only a game that ended without a winner needs an explicit call
+ */
+void GameRecorder::endGame()
+{
+    if (!m_inGame)
+        return;
+    m_inGame = false;
+    
+    // The shots were packed as they came, so only the padding remains
+    size_t size = (m_record.size() + 8 + 7) & ~size_t(7);
+    m_record.resize(size, 0);
+    put32(m_record, 0, static_cast<uint32_t>(size));
+    put32(m_record, 16, static_cast<uint32_t>(m_nShots));
+    put8(m_record, 22, m_firstMover);
+    put8(m_record, 23, m_winner < 0 ? 255 : m_winner);
+    m_out.write(m_record.data(), m_record.size());
+}
+
+void GameRecorder::turnStarted(const Player& attacker, const Player& /* defender */,
+                               const Board& /* b */, bool /* shotsOnly */)
+{
+    if (m_nShots == 0)
+        m_firstMover = (&attacker == m_players[1] ? 1 : 0);
+}
+
+void GameRecorder::attackMade(const Player& /* attacker */, Point p, bool validShot,
+                              bool shotHit, bool shipDestroyed, int shipId,
+                              const Board& /* b */, bool /* shotsOnly */)
+{
+    if (!m_inGame)
+        return;
+    uint64_t shot;
+    if (!validShot)
+    {
+        // A shot off the board keeps no cell
+        bool onBoard = (p.r >= 0 && p.r < m_rows && p.c >= 0 && p.c < m_cols);
+        shot = (onBoard ? p.r * m_cols + p.c : 0) | uint64_t(SHOT_INVALID) << m_cellBits;
+    }
+    else
+    {
+        ShotResult result = (shipDestroyed ? SHOT_SUNK : (shotHit ? SHOT_HIT : SHOT_MISS));
+        shot = uint64_t(p.r * m_cols + p.c) | uint64_t(result) << m_cellBits;
+        if (shipDestroyed)
+            shot |= uint64_t(shipId) << (m_cellBits + 2);
+    }
+    
+    // OR the bits in at the next free position, growing the record a byte at a time
+    uint64_t bit = static_cast<uint64_t>(m_nShots) * m_shotBits;
+    size_t end = m_shotsAt + (bit + m_shotBits + 7) / 8;
+    if (m_record.size() < end)
+        m_record.resize(end, 0);
+    size_t at = m_shotsAt + bit / 8;
+    shot <<= bit % 8;
+    for (; shot != 0; shot >>= 8)
+        m_record[at++] |= static_cast<unsigned char>(shot);
+    m_nShots++;
+}
+
+void GameRecorder::gameWon(const Player& winner)
+{
+    m_winner = (&winner == m_players[1] ? 1 : 0);
+    endGame();
+}
+
+//*********************************************************************
+//  GameRecordView
+//*********************************************************************
+
+/**
+    Returns the name of a ship
+ 
+    @param1 shipId Id of the ship
+    @return The name, pointing into the mapping
+ */
+string_view GameRecordView::shipName(int shipId) const
+{
+    int entry = RECORDHEADERBYTES + 8 * shipId;
+    return string_view(reinterpret_cast<const char*>(m_rec + get32(entry + 4)), m_rec[entry + 3]);
+}
+
+/**
+    Returns the type of a player
+ 
+    @param1 player 0 for the player created first, 1 for the other
+    @return The type as it was passed to createPlayer, pointing into the mapping
+ */
+string_view GameRecordView::playerType(int player) const
+{
+    // The types sit just in front of the shots
+    size_t len0 = m_rec[26];
+    size_t len1 = m_rec[27];
+    const char* types = reinterpret_cast<const char*>(m_shots) - len0 - len1;
+    return (player == 0 ? string_view(types, len0) : string_view(types + len0, len1));
+}
+
+//*********************************************************************
+//  GameRecordReader
+//*********************************************************************
+
+/**
+    GameRecordReader constructor
+ 
+    @param1 path File to map
+    Use isOpen to learn whether the file could be mapped and has a valid header
+ */
+GameRecordReader::GameRecordReader(const string& path)
+: m_data(nullptr), m_size(0), m_pos(FILEHEADERBYTES)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= FILEHEADERBYTES)
+    {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            m_data = static_cast<const unsigned char*>(p);
+            m_size = st.st_size;
+            madvise(p, m_size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+    
+    // Refuse files that are not records of this version
+    if (m_data != nullptr &&
+        (memcmp(m_data, RECORDMAGIC, 8) != 0 ||
+         (m_data[8] | m_data[9] << 8 | m_data[10] << 16 | uint32_t(m_data[11]) << 24) != RECORDVERSION))
+    {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+        m_data = nullptr;
+    }
+}
+
+GameRecordReader::~GameRecordReader()
+{
+    if (m_data != nullptr)
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+/**
+    Moves to the next record
+ 
+    @param1 view Set to the record
+    @return false at the end of the file, or at a record that is cut short or whose
+            offsets and lengths don't fit inside it -- nothing past the record is ever read
+ */
+bool GameRecordReader::next(GameRecordView& view)
+{
+    if (m_data == nullptr || m_pos + RECORDHEADERBYTES > m_size)
+        return false;
+    GameRecordView v;
+    v.m_rec = m_data + m_pos;
+    size_t size = v.get32(0);
+    if (size < RECORDHEADERBYTES || size % 8 != 0 || size > m_size - m_pos)
+        return false;
+    // A game Replay could not build, or players it could not tell apart
+    if (v.rows() < 1 || v.rows() > MAXROWS || v.cols() < 1 || v.cols() > MAXCOLS ||
+        v.firstMover() > 1 || (v.winner() != -1 && v.winner() > 1))
+        return false;
+    
+    // The ship table, the names and the two types must lie in front of the shots
+    size_t tableEnd = RECORDHEADERBYTES + 8 * static_cast<size_t>(v.nShips());
+    size_t shotsAt = v.get32(28);
+    if (tableEnd > size || shotsAt > size || shotsAt < tableEnd + v.m_rec[26] + v.m_rec[27])
+        return false;
+    for (int id = 0; id < v.nShips(); id++)
+    {
+        size_t entry = RECORDHEADERBYTES + 8 * id;
+        size_t nameAt = v.get32(entry + 4);
+        if (nameAt < tableEnd || nameAt > shotsAt || v.m_rec[entry + 3] > shotsAt - nameAt)
+            return false;
+    }
+    
+    // A shot is read with one 8 byte load at any bit offset, so it can have at most
+    // 57 bits, and the last one must leave 8 bytes of padding behind it
+    v.m_shots = v.m_rec + shotsAt;
+    v.m_cellBits = v.m_rec[24];
+    v.m_shotBits = v.m_cellBits + 2 + v.m_rec[25];
+    if (v.m_cellBits < 1 || v.m_shotBits > 57)
+        return false;
+    uint64_t shotBytes = (static_cast<uint64_t>(v.nShots()) * v.m_shotBits + 7) / 8;
+    if (shotBytes + 8 > size - shotsAt)
+        return false;
+    view = v;
+    m_pos += size;
+    return true;
+}
+
+/**
+    Goes back to the first record
+ */
+void GameRecordReader::rewind()
+{
+    m_pos = FILEHEADERBYTES;
+}
@@ -0,0 +1,183 @@
+#ifndef GAMERECORD_INCLUDED
+#define GAMERECORD_INCLUDED
+
+#include "GameObserver.h"
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Game;
+
+// A record file is a 16 byte file header followed by one record per game.
+// A record starts with a fixed 32 byte header (every field little-endian):
+//
+//    0  u32  size of the whole record in bytes, a multiple of 8
+//    4  u16  rows            6  u16  columns
+//    8  u64  seed the game was given
+//   16  u32  number of shots
+//   20  u16  number of ships
+//   22  u8   player that moved first (0 or 1)
+//   23  u8   winner (0 or 1), or 255 if the game had no result
+//   24  u8   bits of a shot's cell index
+//   25  u8   bits of a shot's ship id
+//   26  u8   length of player 0's type   27  u8  length of player 1's type
+//   28  u32  offset of the shots from the start of the record
+//
+// Then one 8 byte entry per ship -- u16 length, u8 symbol, u8 name length,
+// u32 name offset -- followed by the names, the two player types, and the
+// shots.  Players are numbered in the order they were created.  The players
+// take turns, so shot k was fired by the first mover when k is even.  Each
+// shot is packed into the same number of bits, lowest bits first: the cell
+// index (row * columns + column), two bits of result, then the id of the
+// ship it sank.  Every record ends with at least 8 bytes of padding, so a
+// shot can always be read with one unaligned 8 byte load.
+
+enum ShotResult {
+    SHOT_MISS, SHOT_HIT, SHOT_SUNK, SHOT_INVALID
+};
+
+struct RecordedShot
+{
+    int cell;
+    ShotResult result;
+    int shipId;
+};
+
+// Appends finished game records to a file.  Recorders on different threads
+// may share one writer: each hands over whole records, which are buffered
+// and written in large blocks.
+class GameRecordWriter
+{
+public:
+    GameRecordWriter(const std::string& path);
+    ~GameRecordWriter();
+    bool isOpen() const { return m_file.is_open(); }
+    void write(const unsigned char* record, std::size_t nBytes);
+    void flush();
+    // We prevent a GameRecordWriter object from being copied or assigned
+    GameRecordWriter(const GameRecordWriter&) = delete;
+    GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+    
+private:
+    void flushLocked();
+    
+    std::mutex m_lock;
+    std::ofstream m_file;
+    std::vector<unsigned char> m_buffer;
+};
+
+// Encodes the game it observes into a record.  Call beginGame before
+// Game::play, and pass the recorder as the observer; the record goes to
+// the writer once the game is won, or at endGame if it had no result.
+class GameRecorder : public GameObserver
+{
+public:
+    GameRecorder(GameRecordWriter& out);
+    ~GameRecorder();
+    void beginGame(const Game& g, std::uint64_t seed,
+                   const Player& p0, const std::string& type0,
+                   const Player& p1, const std::string& type1);
+    void endGame();
+    
+    virtual void turnStarted(const Player& attacker, const Player& defender,
+                             const Board& b, bool shotsOnly);
+    virtual void attackMade(const Player& attacker, Point p, bool validShot,
+                            bool shotHit, bool shipDestroyed, int shipId,
+                            const Board& b, bool shotsOnly);
+    virtual void gameWon(const Player& winner);
+    
+private:
+    GameRecordWriter& m_out;
+    std::vector<unsigned char> m_record;
+    const Player* m_players[2];
+    int m_rows, m_cols;
+    int m_cellBits, m_shotBits;
+    std::size_t m_shotsAt;
+    long m_nShots;
+    int m_firstMover;
+    int m_winner;
+    bool m_inGame;
+};
+
+// One record of a mapped file.  It only points into the mapping, so it is
+// valid as long as the reader that produced it.
+class GameRecordView
+{
+public:
+    GameRecordView() : m_rec(nullptr) {}
+    int rows() const { return get16(4); }
+    int cols() const { return get16(6); }
+    std::uint64_t seed() const { return get64(8); }
+    long nShots() const { return get32(16); }
+    int nShips() const { return get16(20); }
+    int shipLength(int shipId) const { return get16(32 + 8 * shipId); }
+    char shipSymbol(int shipId) const { return static_cast<char>(m_rec[34 + 8 * shipId]); }
+    std::string_view shipName(int shipId) const;
+    std::string_view playerType(int player) const;
+    int firstMover() const { return m_rec[22]; }
+    int winner() const { return m_rec[23] == 255 ? -1 : m_rec[23]; }
+    
+    /**
+        Decodes one shot straight from the mapping
+     
+        @param1 k Index of the shot -- 0 is the first shot of the game
+        @return The cell shot at, the result, and the id of the ship sunk if any
+     */
+    RecordedShot shot(long k) const
+    {
+        std::uint64_t bit = static_cast<std::uint64_t>(k) * m_shotBits;
+        const unsigned char* p = m_shots + (bit >> 3);
+        std::uint64_t word = 0;
+        for (int i = 0; i < 8; i++)
+            word |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+        word >>= bit & 7;
+        RecordedShot s;
+        s.cell = static_cast<int>(word & ((std::uint64_t(1) << m_cellBits) - 1));
+        s.result = static_cast<ShotResult>((word >> m_cellBits) & 3);
+        s.shipId = static_cast<int>((word >> (m_cellBits + 2)) &
+                                    ((std::uint64_t(1) << (m_shotBits - m_cellBits - 2)) - 1));
+        return s;
+    }
+    
+private:
+    friend class GameRecordReader;
+    
+    int get16(int at) const { return m_rec[at] | m_rec[at + 1] << 8; }
+    std::uint32_t get32(int at) const
+    {
+        return get16(at) | static_cast<std::uint32_t>(get16(at + 2)) << 16;
+    }
+    std::uint64_t get64(int at) const
+    {
+        return get32(at) | static_cast<std::uint64_t>(get32(at + 4)) << 32;
+    }
+    
+    const unsigned char* m_rec;
+    const unsigned char* m_shots;
+    int m_cellBits, m_shotBits;
+};
+
+// Maps a record file into memory and walks its records in order without
+// copying or allocating.  Needs a POSIX system for mmap.
+class GameRecordReader
+{
+public:
+    GameRecordReader(const std::string& path);
+    ~GameRecordReader();
+    bool isOpen() const { return m_data != nullptr; }
+    bool next(GameRecordView& view);
+    void rewind();
+    // We prevent a GameRecordReader object from being copied or assigned
+    GameRecordReader(const GameRecordReader&) = delete;
+    GameRecordReader& operator=(const GameRecordReader&) = delete;
+    
+private:
+    const unsigned char* m_data;
+    std::size_t m_size;
+    std::size_t m_pos;
+};
+
+#endif // GAMERECORD_INCLUDED
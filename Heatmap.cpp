@@ -0,0 +1,123 @@
+#include "Heatmap.h"
+#include <algorithm>
+
+using namespace std;
+
+/**
+    Heatmap constructor
+ 
+    @param1 table The placements of the board size and fleet
+    Starts with every placement alive and computes the starting heat
+ */
+Heatmap::Heatmap(shared_ptr<const PlacementTable> table)
+: m_table(table), m_classes(table->nLengths()),
+  m_blocked(table->rows() * table->cols(), 0), m_heat(table->rows() * table->cols(), 0)
+{
+    reset();
+}
+
+/**
+    Heatmap constructor
+ 
+    @param1 nRows Number of rows of the board
+    @param2 nCols Number of columns of the board
+    @param3 shipLengths Length of every ship of the fleet
+ */
+Heatmap::Heatmap(int nRows, int nCols, const vector<int>& shipLengths)
+: Heatmap(PlacementTable::get(nRows, nCols, shipLengths))
+{}
+
+/**
+    Brings the whole fleet back and unblocks every cell
+ 
+    The storage is kept, so a heatmap can serve game after game
+ */
+void Heatmap::reset()
+{
+    fill(m_blocked.begin(), m_blocked.end(), 0);
+    for (int li = 0; li < m_table->nLengths(); li++)
+    {
+        m_classes[li].m_count = m_table->nShips(li);
+        m_classes[li].m_alive.assign(m_table->nPlacements(li), 1);
+    }
+    rebuild();
+}
+
+/**
+    Adds amount to the heat of every cell of a placement
+ */
+void Heatmap::addPlacement(int li, int pl, long long amount)
+{
+    int step = m_table->step(li, pl);
+    for (int k = 0, cell = m_table->start(li, pl); k < m_table->length(li); k++, cell += step)
+        m_heat[cell] += amount;
+}
+
+/**
+    Blocks a cell -- a miss, or a cell of a sunk ship
+ 
+    @param1 cell The cell, as row*cols + col
+    Only the live placements through the cell are touched
+ */
+void Heatmap::block(int cell)
+{
+    if (m_blocked[cell])
+        return;
+    m_blocked[cell] = 1;
+    for (int li = 0; li < m_table->nLengths(); li++)
+    {
+        LengthClass& lc = m_classes[li];
+        const int* through = m_table->through(li, cell);
+        for (int k = 0; k < m_table->nThrough(li, cell); k++)
+        {
+            int pl = through[k];
+            if (!lc.m_alive[pl])
+                continue;
+            lc.m_alive[pl] = 0;
+            if (lc.m_count > 0)
+                addPlacement(li, pl, -lc.m_count);
+        }
+    }
+}
+
+/**
+    Removes one ship from the fleet
+ 
+    @param1 len The length of the sunk ship
+    Only the live placements of that length are touched
+ */
+void Heatmap::shipSunk(int len)
+{
+    int li = m_table->lengthIndex(len);
+    if (li < 0 || m_classes[li].m_count == 0)
+        return;
+    LengthClass& lc = m_classes[li];
+    lc.m_count--;
+    for (int pl = 0; pl < m_table->nPlacements(li); pl++)
+        if (lc.m_alive[pl])
+            addPlacement(li, pl, -1);
+}
+
+/**
+    Recomputes every cell's heat from scratch
+ 
+    Visits every placement of every surviving ship -- the full cost that block and shipSunk avoid
+ */
+void Heatmap::rebuild()
+{
+    fill(m_heat.begin(), m_heat.end(), 0);
+    for (int li = 0; li < m_table->nLengths(); li++)
+    {
+        LengthClass& lc = m_classes[li];
+        for (int pl = 0; pl < m_table->nPlacements(li); pl++)
+        {
+            bool alive = true;
+            int start = m_table->start(li, pl), step = m_table->step(li, pl);
+            for (int k = 0; alive && k < m_table->length(li); k++)
+                alive = !m_blocked[start + k * step];
+            lc.m_alive[pl] = alive;
+            if (alive && lc.m_count > 0)
+                addPlacement(li, pl, lc.m_count);
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef HEATMAP_INCLUDED
+#define HEATMAP_INCLUDED
+
+#include "PlacementTable.h"
+#include <memory>
+#include <vector>
+
+// For every cell, the number of placements of the surviving ships that
+// cover it without touching a blocked cell (a miss or a sunk ship).  The
+// counts are kept up to date incrementally: blocking a cell only visits
+// the placements through that cell, and sinking a ship only visits the
+// placements of its length.  The placements themselves come from the
+// geometry's shared PlacementTable; a heatmap only tracks which are alive.
+class Heatmap
+{
+public:
+    Heatmap(std::shared_ptr<const PlacementTable> table);
+    Heatmap(int nRows, int nCols, const std::vector<int>& shipLengths);
+    
+    int nCells() const { return m_table->rows() * m_table->cols(); }
+    long long heat(int cell) const { return m_heat[cell]; }
+    bool isBlocked(int cell) const { return m_blocked[cell] != 0; }
+    
+    void reset();
+    void block(int cell);
+    void shipSunk(int len);
+    void rebuild();
+    
+    // Calls f(start, step, len, count) for every live placement covering cell,
+    // where count is the number of surviving ships of that length
+    template <class F>
+    void forEachPlacementThrough(int cell, F f) const
+    {
+        const PlacementTable& t = *m_table;
+        for (int li = 0; li < t.nLengths(); li++)
+        {
+            const LengthClass& lc = m_classes[li];
+            if (lc.m_count == 0)
+                continue;
+            const int* through = t.through(li, cell);
+            for (int k = 0; k < t.nThrough(li, cell); k++)
+            {
+                int pl = through[k];
+                if (lc.m_alive[pl])
+                    f(t.start(li, pl), t.step(li, pl), t.length(li), lc.m_count);
+            }
+        }
+    }
+    
+private:
+    // The surviving ships of one length, and which of its placements are still possible
+    struct LengthClass
+    {
+        int m_count;
+        std::vector<char> m_alive;
+    };
+    void addPlacement(int li, int pl, long long amount);
+    
+    std::shared_ptr<const PlacementTable> m_table;
+    std::vector<LengthClass> m_classes;
+    std::vector<char> m_blocked;
+    std::vector<long long> m_heat;
+};
+
+#endif // HEATMAP_INCLUDED
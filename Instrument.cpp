@@ -0,0 +1,328 @@
+#include "Instrument.h"
+
+#ifdef BATTLESHIP_INSTRUMENT
+
+#include "Player.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+namespace
+{
+    // Values below 8 get a bucket each; above that every power of two is split in 8,
+    // so a bucket is never more than 12.5% wide
+    const int NBUCKETS = 62 * 8;
+    const int MAXTYPES = 32;
+
+    int bucketOf(uint64_t v)
+    {
+        if (v < 8)
+            return static_cast<int>(v);
+        int e = 63 - __builtin_clzll(v);
+        return (e - 2) * 8 + static_cast<int>((v >> (e - 3)) & 7);
+    }
+
+    // Largest value that falls in a bucket
+    uint64_t bucketTop(int b)
+    {
+        if (b < 8)
+            return b;
+        int e = b / 8 + 2;
+        uint64_t low = static_cast<uint64_t>(8 + b % 8) << (e - 3);
+        return low + (uint64_t(1) << (e - 3)) - 1;
+    }
+
+    // Only the owning thread adds, so a plain load and store is enough;
+    // the atomics make it safe for a report to read at the same time
+    void add(atomic<uint64_t>& a, uint64_t n)
+    {
+        a.store(a.load(memory_order_relaxed) + n, memory_order_relaxed);
+    }
+
+    // Everything one thread recorded for one player type
+    struct TypeStats
+    {
+        atomic<uint64_t> buckets[NHISTOGRAMS][NBUCKETS];
+        atomic<uint64_t> max[NHISTOGRAMS];
+        atomic<uint64_t> counters[NCOUNTERS];
+
+        TypeStats() { clear(); }
+        void clear()
+        {
+            for (int h = 0; h < NHISTOGRAMS; h++)
+            {
+                for (int b = 0; b < NBUCKETS; b++)
+                    buckets[h][b].store(0, memory_order_relaxed);
+                max[h].store(0, memory_order_relaxed);
+            }
+            for (int c = 0; c < NCOUNTERS; c++)
+                counters[c].store(0, memory_order_relaxed);
+        }
+        void mergeInto(TypeStats& total) const
+        {
+            for (int h = 0; h < NHISTOGRAMS; h++)
+            {
+                for (int b = 0; b < NBUCKETS; b++)
+                    add(total.buckets[h][b], buckets[h][b].load(memory_order_relaxed));
+                uint64_t m = max[h].load(memory_order_relaxed);
+                if (m > total.max[h].load(memory_order_relaxed))
+                    total.max[h].store(m, memory_order_relaxed);
+            }
+            for (int c = 0; c < NCOUNTERS; c++)
+                add(total.counters[c], counters[c].load(memory_order_relaxed));
+        }
+    };
+
+    class Shard;
+
+    // Shared by all threads, and only touched under its lock
+    struct Registry
+    {
+        mutex lock;
+        vector<string> types;
+        vector<Shard*> shards;
+        // What threads that have exited recorded
+        unique_ptr<TypeStats> retired[MAXTYPES];
+    };
+
+    Registry& registry()
+    {
+        static Registry* r = new Registry;
+        return *r;
+    }
+
+    // One thread's records -- registered on first use, folded into the
+    // registry's retired totals when the thread exits
+    class Shard
+    {
+    public:
+        Shard() : m_nCached(0)
+        {
+            Registry& r = registry();
+            lock_guard<mutex> guard(r.lock);
+            r.shards.push_back(this);
+        }
+        ~Shard()
+        {
+            Registry& r = registry();
+            lock_guard<mutex> guard(r.lock);
+            for (int t = 0; t < MAXTYPES; t++)
+                if (m_stats[t] != nullptr)
+                {
+                    if (r.retired[t] == nullptr)
+                        r.retired[t].reset(new TypeStats);
+                    m_stats[t]->mergeInto(*r.retired[t]);
+                }
+            r.shards.erase(find(r.shards.begin(), r.shards.end(), this));
+        }
+
+        // Stats of a player's type, or nullptr once there are too many types
+        TypeStats* statsFor(const Player& p)
+        {
+            // typeName returns a literal, so the pointer identifies the type
+            const char* name = p.typeName();
+            for (int i = 0; i < m_nCached; i++)
+                if (m_cachedName[i] == name)
+                    return m_cachedStats[i];
+            int t = typeId(name);
+            if (t < 0 || m_nCached == MAXTYPES)
+                return nullptr;
+            if (m_stats[t] == nullptr)
+            {
+                // Published under the lock, so a report never sees it half built
+                unique_ptr<TypeStats> s(new TypeStats);
+                lock_guard<mutex> guard(registry().lock);
+                m_stats[t] = move(s);
+            }
+            m_cachedName[m_nCached] = name;
+            m_cachedStats[m_nCached++] = m_stats[t].get();
+            return m_stats[t].get();
+        }
+        const TypeStats* stats(int t) const { return m_stats[t].get(); }
+        TypeStats* stats(int t) { return m_stats[t].get(); }
+
+    private:
+        static int typeId(const char* name)
+        {
+            Registry& r = registry();
+            lock_guard<mutex> guard(r.lock);
+            for (size_t t = 0; t < r.types.size(); t++)
+                if (r.types[t] == name)
+                    return static_cast<int>(t);
+            if (r.types.size() == MAXTYPES)
+                return -1;
+            r.types.push_back(name);
+            return static_cast<int>(r.types.size()) - 1;
+        }
+
+        unique_ptr<TypeStats> m_stats[MAXTYPES];
+        const char* m_cachedName[MAXTYPES];
+        TypeStats* m_cachedStats[MAXTYPES];
+        int m_nCached;
+    };
+
+    Shard& threadShard()
+    {
+        thread_local Shard shard;
+        return shard;
+    }
+
+    // Smallest value with at least the given fraction of the samples at or below it
+    uint64_t percentile(const TypeStats& s, int h, uint64_t count, double fraction)
+    {
+        uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(fraction * count + 0.5));
+        uint64_t seen = 0;
+        for (int b = 0; b < NBUCKETS; b++)
+        {
+            seen += s.buckets[h][b].load(memory_order_relaxed);
+            if (seen >= rank)
+                return min(bucketTop(b), s.max[h].load(memory_order_relaxed));
+        }
+        return s.max[h].load(memory_order_relaxed);
+    }
+}
+
+/**
+    Adds a value to a histogram of a player's type
+
+    @param1 p The player -- its typeName picks the histograms
+    @param2 h Which histogram
+    @param3 value The value, e.g. a latency in nanoseconds
+ */
+void instrumentRecord(const Player& p, InstrumentHistogram h, uint64_t value)
+{
+    TypeStats* s = threadShard().statsFor(p);
+    if (s == nullptr)
+        return;
+    add(s->buckets[h][bucketOf(value)], 1);
+    if (value > s->max[h].load(memory_order_relaxed))
+        s->max[h].store(value, memory_order_relaxed);
+}
+
+/**
+    Adds to a counter of a player's type
+
+    @param1 p The player
+    @param2 c Which counter
+    @param3 n Amount to add
+ */
+void instrumentCount(const Player& p, InstrumentCounter c, uint64_t n)
+{
+    TypeStats* s = threadShard().statsFor(p);
+    if (s != nullptr)
+        add(s->counters[c], n);
+}
+
+/**
+    Merges what every thread has recorded so far
+
+    @return One report per player type seen, in the order the types were first seen
+ */
+vector<InstrumentReport> instrumentReport()
+{
+    Registry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+    vector<InstrumentReport> reports;
+    for (size_t t = 0; t < r.types.size(); t++)
+    {
+        TypeStats total;
+        if (r.retired[t] != nullptr)
+            r.retired[t]->mergeInto(total);
+        for (const Shard* shard : r.shards)
+            if (shard->stats(t) != nullptr)
+                shard->stats(t)->mergeInto(total);
+
+        InstrumentReport report;
+        report.type = r.types[t];
+        for (int h = 0; h < NHISTOGRAMS; h++)
+        {
+            HistogramSummary& hs = report.histograms[h];
+            for (int b = 0; b < NBUCKETS; b++)
+                hs.count += total.buckets[h][b].load(memory_order_relaxed);
+            if (hs.count == 0)
+                continue;
+            hs.p50 = percentile(total, h, hs.count, 0.50);
+            hs.p99 = percentile(total, h, hs.count, 0.99);
+            hs.max = total.max[h].load(memory_order_relaxed);
+        }
+        for (int c = 0; c < NCOUNTERS; c++)
+            report.counters[c] = total.counters[c].load(memory_order_relaxed);
+        reports.push_back(report);
+    }
+    return reports;
+}
+
+/**
+    Writes the merged report as a table, one block per player type
+
+    @param1 out Where to write it
+ */
+void printInstrumentReport(ostream& out)
+{
+    static const char* const histogramNames[NHISTOGRAMS] = {
+        "placeShips ns", "recommendAttack ns", "recordAttackResult ns", "target queue size"
+    };
+    static const char* const counterNames[NCOUNTERS] = {
+        "placement retries", "placement failures", "invalid shots"
+    };
+    for (const InstrumentReport& r : instrumentReport())
+    {
+        out << r.type << ":" << endl;
+        for (int h = 0; h < NHISTOGRAMS; h++)
+        {
+            const HistogramSummary& hs = r.histograms[h];
+            if (hs.count == 0)
+                continue;
+            out << "  " << left << setw(24) << histogramNames[h] << right
+            << setw(12) << hs.count << "  p50 " << setw(10) << hs.p50
+            << "  p99 " << setw(10) << hs.p99 << "  max " << setw(10) << hs.max << endl;
+        }
+        for (int c = 0; c < NCOUNTERS; c++)
+            if (r.counters[c] != 0)
+                out << "  " << left << setw(24) << counterNames[c] << right
+                << setw(12) << r.counters[c] << endl;
+    }
+}
+
+/**
+    Forgets everything recorded so far
+
+    Meant for between runs -- a thread recording at the same time may keep a few counts
+ */
+void instrumentReset()
+{
+    Registry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+    for (int t = 0; t < MAXTYPES; t++)
+    {
+        if (r.retired[t] != nullptr)
+            r.retired[t]->clear();
+        for (Shard* shard : r.shards)
+            if (shard->stats(t) != nullptr)
+                shard->stats(t)->clear();
+    }
+}
+
+static int64_t nowNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+InstrumentTimer::InstrumentTimer(const Player& p, InstrumentHistogram h)
+: m_player(p), m_histogram(h), m_start(nowNs())
+{}
+
+InstrumentTimer::~InstrumentTimer()
+{
+    instrumentRecord(m_player, m_histogram, static_cast<uint64_t>(nowNs() - m_start));
+}
+
+#endif // BATTLESHIP_INSTRUMENT
@@ -0,0 +1,89 @@
+#ifndef INSTRUMENT_INCLUDED
+#define INSTRUMENT_INCLUDED
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class Player;
+
+// Measurements of the players, kept per player type.  Define
+// BATTLESHIP_INSTRUMENT to turn them on; otherwise every call below is an
+// empty inline function and the instrumented code compiles as if it were
+// not there.  Each thread records into its own counters, so recording
+// takes no lock; instrumentReport merges the threads when asked.
+
+// What is recorded as a distribution -- latencies in nanoseconds
+enum InstrumentHistogram {
+    LATENCY_PLACESHIPS, LATENCY_RECOMMENDATTACK, LATENCY_RECORDATTACKRESULT,
+    SIZE_TARGETQUEUE, NHISTOGRAMS
+};
+
+// What is only counted
+enum InstrumentCounter {
+    COUNT_PLACEMENTRETRIES, COUNT_PLACEMENTFAILURES, COUNT_INVALIDSHOTS, NCOUNTERS
+};
+
+struct HistogramSummary
+{
+    std::uint64_t count = 0;
+    std::uint64_t p50 = 0;
+    std::uint64_t p99 = 0;
+    std::uint64_t max = 0;
+};
+
+// Everything recorded for one player type, merged over all threads
+struct InstrumentReport
+{
+    std::string type;
+    HistogramSummary histograms[NHISTOGRAMS];
+    std::uint64_t counters[NCOUNTERS] = {};
+};
+
+#ifdef BATTLESHIP_INSTRUMENT
+
+void instrumentRecord(const Player& p, InstrumentHistogram h, std::uint64_t value);
+void instrumentCount(const Player& p, InstrumentCounter c, std::uint64_t n = 1);
+std::vector<InstrumentReport> instrumentReport();
+void printInstrumentReport(std::ostream& out);
+void instrumentReset();
+
+// Records the time from its construction to its destruction
+class InstrumentTimer
+{
+public:
+    InstrumentTimer(const Player& p, InstrumentHistogram h);
+    ~InstrumentTimer();
+
+private:
+    const Player& m_player;
+    InstrumentHistogram m_histogram;
+    std::int64_t m_start;
+};
+
+#else
+
+inline void instrumentRecord(const Player&, InstrumentHistogram, std::uint64_t) {}
+inline void instrumentCount(const Player&, InstrumentCounter, std::uint64_t = 1) {}
+inline std::vector<InstrumentReport> instrumentReport() { return std::vector<InstrumentReport>(); }
+inline void printInstrumentReport(std::ostream&) {}
+inline void instrumentReset() {}
+
+class InstrumentTimer
+{
+public:
+    InstrumentTimer(const Player&, InstrumentHistogram) {}
+};
+
+#endif // BATTLESHIP_INSTRUMENT
+
+// Calls f, timing it into a latency histogram of p's type
+template <class F>
+inline auto instrumentTimed(const Player& p, InstrumentHistogram h, F f) -> decltype(f())
+{
+    InstrumentTimer timer(p, h);
+    return f();
+}
+
+#endif // INSTRUMENT_INCLUDED
@@ -0,0 +1,550 @@
+#include "LayoutCounter.h"
+#include "Game.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+using namespace std;
+
+//*********************************************************************
+//  CountTable
+//*********************************************************************
+
+// Open-addressed map from profile state to layout count, cleared and
+// refilled once per cell of the dynamic program without freeing memory
+class CountTable
+{
+public:
+    CountTable() : m_size(0) { resize(1024); }
+    
+    size_t size() const { return m_size; }
+    
+    void clear()
+    {
+        fill(m_keys.begin(), m_keys.end(), EMPTY);
+        m_size = 0;
+    }
+    
+    void add(uint64_t key, unsigned long long n)
+    {
+        if (2 * (m_size + 1) > m_keys.size())
+            resize(2 * m_keys.size());
+        size_t mask = m_keys.size() - 1;
+        size_t i = Rng::mix(key) & mask;
+        while (m_keys[i] != key && m_keys[i] != EMPTY)
+            i = (i + 1) & mask;
+        if (m_keys[i] == EMPTY)
+        {
+            m_keys[i] = key;
+            m_counts[i] = 0;
+            m_size++;
+        }
+        m_counts[i] += n;
+    }
+    
+    unsigned long long find(uint64_t key) const
+    {
+        size_t mask = m_keys.size() - 1;
+        for (size_t i = Rng::mix(key) & mask; m_keys[i] != EMPTY; i = (i + 1) & mask)
+            if (m_keys[i] == key)
+                return m_counts[i];
+        return 0;
+    }
+    
+    template <class F>
+    void forEach(F f) const
+    {
+        for (size_t i = 0; i < m_keys.size(); i++)
+            if (m_keys[i] != EMPTY)
+                f(m_keys[i], m_counts[i]);
+    }
+    
+private:
+    // No state has every bit set: the used-ship bits never reach the top
+    static constexpr uint64_t EMPTY = ~uint64_t(0);
+    
+    void resize(size_t capacity)
+    {
+        vector<uint64_t> keys(capacity, EMPTY);
+        vector<unsigned long long> counts(capacity);
+        swap(keys, m_keys);
+        swap(counts, m_counts);
+        m_size = 0;
+        for (size_t i = 0; i < keys.size(); i++)
+            if (keys[i] != EMPTY)
+                add(keys[i], counts[i]);
+    }
+    
+    vector<uint64_t> m_keys;
+    vector<unsigned long long> m_counts;
+    size_t m_size;
+};
+
+//*********************************************************************
+//  LayoutCounter
+//*********************************************************************
+
+/**
+    LayoutCounter constructor
+ 
+    @param1 g The game whose board size and fleet are counted
+ */
+LayoutCounter::LayoutCounter(const Game& g)
+: m_rows(g.rows()), m_cols(g.cols())
+{
+    for (int id = 0; id < g.nShips(); id++)
+        m_lengths.push_back(g.shipLength(id));
+}
+
+/**
+    Counts the layouts that agree with the constraints
+ 
+    @param1 c What is known about the board
+    @param2 nThreads Number of threads to use -- 0 means one per hardware thread
+    @return The number of layouts
+ */
+unsigned long long LayoutCounter::count(const LayoutConstraints& c, int nThreads) const
+{
+    ThreadPool pool(nThreads);
+    unsigned long long total = 0;
+    forEachProblem(c, [&](const Problem& pb)
+    {
+        // Splitting costs several times the work of one pass, so it only pays on many threads
+        if (pool.size() == 1 || pb.ships.empty())
+            total += countProfile(pb);
+        else
+            for (const PlaceCount& pc : countPlaces(pb, 0, &pool))
+                total += pc.count;
+        return true;
+    });
+    return total;
+}
+
+/**
+    Counts, for every cell, the layouts that agree with the constraints and put a ship there
+    Dividing by count() gives the exact chance that each cell holds a ship
+ 
+    @param1 c What is known about the board
+    @param2 nThreads Number of threads to use -- 0 means one per hardware thread
+    @return One count per cell, in row-major order
+ */
+vector<unsigned long long> LayoutCounter::occupancy(const LayoutConstraints& c, int nThreads) const
+{
+    ThreadPool pool(nThreads);
+    vector<unsigned long long> counts(m_rows * m_cols, 0);
+    forEachProblem(c, [&](const Problem& pb)
+    {
+        // Ships cannot overlap, so a cell is covered in as many layouts as
+        // each ship covers it, summed over the ships.  Swapping two ships of
+        // equal length maps layouts onto layouts, so one of them stands for all.
+        unsigned long long total = (pb.ships.empty() ? countProfile(pb) : 0);
+        for (int k = 0; k < (int)pb.ships.size(); k++)
+        {
+            int len = m_lengths[pb.ships[k]];
+            int equal = 0;
+            bool first = true;
+            for (int j = 0; j < (int)pb.ships.size(); j++)
+                if (m_lengths[pb.ships[j]] == len)
+                {
+                    equal++;
+                    if (j < k)
+                        first = false;
+                }
+            if (!first)
+                continue;
+            for (const PlaceCount& pc : countPlaces(pb, k, &pool))
+            {
+                if (k == 0)
+                    total += pc.count;
+                int step = (pc.place.dir == HORIZONTAL ? 1 : m_cols);
+                int start = pc.place.topOrLeft.r * m_cols + pc.place.topOrLeft.c;
+                for (int i = 0; i < len; i++)
+                    counts[start + i * step] += pc.count * equal;
+            }
+        }
+        
+        // Cells under a sunk ship are covered in every layout of this problem
+        for (int id = 0; id < (int)pb.fixed.size(); id++)
+        {
+            const ShipPlacement& sp = pb.fixed[id];
+            if (sp.topOrLeft.r < 0)
+                continue;
+            int step = (sp.dir == HORIZONTAL ? 1 : m_cols);
+            int start = sp.topOrLeft.r * m_cols + sp.topOrLeft.c;
+            for (int i = 0; i < m_lengths[id]; i++)
+                counts[start + i * step] += total;
+        }
+        return true;
+    });
+    return counts;
+}
+
+/**
+    Calls visit once for every layout that agrees with the constraints
+ 
+    @param1 c What is known about the board
+    @param2 visit Given each layout, indexed by ship id -- returns false to stop
+    @return False if visit stopped the enumeration, otherwise true
+ */
+bool LayoutCounter::enumerate(const LayoutConstraints& c,
+                              const function<bool(const vector<ShipPlacement>&)>& visit) const
+{
+    vector<char> occ(m_rows * m_cols, false);
+    return forEachProblem(c, [&](const Problem& pb)
+    {
+        vector<ShipPlacement> layout = pb.fixed;
+        // Depth-first over the ships still afloat, one per level
+        function<bool(int)> place = [&](int k) -> bool
+        {
+            if (k == (int)pb.ships.size())
+            {
+                for (int cell = 0; cell < (int)occ.size(); cell++)
+                    if (pb.required[cell] && !occ[cell])
+                        return true;
+                return visit(layout);
+            }
+            int id = pb.ships[k];
+            int len = m_lengths[id];
+            for (int cell = 0; cell < (int)occ.size(); cell++)
+                for (int d = 0; d < (len == 1 ? 1 : 2); d++)
+                {
+                    Direction dir = (d == 0 ? HORIZONTAL : VERTICAL);
+                    int step = (dir == HORIZONTAL ? 1 : m_cols);
+                    if (!spanOk(pb, cell, dir, len))
+                        continue;
+                    int i = 0;
+                    while (i < len && !occ[cell + i * step])
+                        i++;
+                    if (i < len)
+                        continue;
+                    for (i = 0; i < len; i++)
+                        occ[cell + i * step] = true;
+                    layout[id].topOrLeft = Point(cell / m_cols, cell % m_cols);
+                    layout[id].dir = dir;
+                    bool more = place(k + 1);
+                    for (i = 0; i < len; i++)
+                        occ[cell + i * step] = false;
+                    if (!more)
+                        return false;
+                }
+            return true;
+        };
+        return place(0);
+    });
+}
+
+//*********************************************************************
+//  Problem setup
+//*********************************************************************
+
+/**
+    Turns the constraints into one problem per way of placing the sunk ships
+    A sunk ship must lie on hits only and cover the cell that sank it, which
+    seldom leaves more than one choice
+ 
+    @param1 c What is known about the board
+    @param2 f Called with each problem -- returns false to stop
+    @return False if f stopped, otherwise true
+ */
+template <class F>
+bool LayoutCounter::forEachProblem(const LayoutConstraints& c, F f) const
+{
+    int nCells = m_rows * m_cols;
+    Problem pb;
+    pb.blocked.assign(nCells, false);
+    pb.hit.assign(nCells, false);
+    pb.required.assign(nCells, false);
+    pb.fixed.assign(m_lengths.size(), ShipPlacement{Point(-1, -1), HORIZONTAL});
+    auto inside = [&](Point p)
+    {
+        return p.r >= 0 && p.r < m_rows && p.c >= 0 && p.c < m_cols;
+    };
+    for (Point p : c.misses)
+        if (inside(p))
+            pb.blocked[p.r * m_cols + p.c] = true;
+    for (Point p : c.hits)
+        if (inside(p))
+        {
+            pb.hit[p.r * m_cols + p.c] = true;
+            pb.required[p.r * m_cols + p.c] = true;
+        }
+    
+    // A ship sunk twice, or an unknown ship, means no layout fits
+    vector<char> sunk(m_lengths.size(), false);
+    for (const LayoutConstraints::Sunk& s : c.sunk)
+    {
+        if (s.shipId < 0 || s.shipId >= (int)m_lengths.size() || sunk[s.shipId] || !inside(s.at))
+            return true;
+        sunk[s.shipId] = true;
+    }
+    for (int id = 0; id < (int)m_lengths.size(); id++)
+        if (!sunk[id])
+            pb.ships.push_back(id);
+    
+    // Try every place for each sunk ship in turn
+    function<bool(int)> fix = [&](int k) -> bool
+    {
+        if (k == (int)c.sunk.size())
+            return f(pb);
+        int id = c.sunk[k].shipId;
+        int len = m_lengths[id];
+        int at = c.sunk[k].at.r * m_cols + c.sunk[k].at.c;
+        for (int d = 0; d < (len == 1 ? 1 : 2); d++)
+        {
+            Direction dir = (d == 0 ? HORIZONTAL : VERTICAL);
+            int step = (dir == HORIZONTAL ? 1 : m_cols);
+            for (int offset = 0; offset < len; offset++)
+            {
+                int start = at - offset * step;
+                int r = start / m_cols, col = start % m_cols;
+                if (start < 0 || (dir == HORIZONTAL ? r != at / m_cols || col + len > m_cols
+                                                    : r + len > m_rows))
+                    continue;
+                int i = 0;
+                while (i < len && pb.hit[start + i * step] && !pb.blocked[start + i * step])
+                    i++;
+                if (i < len)
+                    continue;
+                Problem saved = pb;
+                claim(pb, start, dir, len);
+                pb.fixed[id] = ShipPlacement{Point(r, col), dir};
+                bool more = fix(k + 1);
+                pb = saved;
+                if (!more)
+                    return false;
+            }
+        }
+        return true;
+    };
+    return fix(0);
+}
+
+/**
+    Determines whether a ship still afloat may lie on a span
+ 
+    @param1 pb The problem
+    @param2 cell The top or left cell of the span
+    @param3 dir The direction of the span
+    @param4 len The length of the span
+    @return True if the span is on the board, avoids blocked cells and is not all hits
+ */
+bool LayoutCounter::spanOk(const Problem& pb, int cell, Direction dir, int len) const
+{
+    int r = cell / m_cols, c = cell % m_cols;
+    if (dir == HORIZONTAL ? c + len > m_cols : r + len > m_rows)
+        return false;
+    int step = (dir == HORIZONTAL ? 1 : m_cols);
+    bool allHits = true;
+    for (int i = 0; i < len; i++)
+    {
+        if (pb.blocked[cell + i * step])
+            return false;
+        if (!pb.hit[cell + i * step])
+            allHits = false;
+    }
+    // A ship lying on hits only would have been reported sunk
+    return !allHits;
+}
+
+/**
+    Gives a span to one ship, so no other ship may use it and its hits are explained
+ 
+    @param1 pb The problem
+    @param2 cell The top or left cell of the span
+    @param3 dir The direction of the span
+    @param4 len The length of the span
+ */
+void LayoutCounter::claim(Problem& pb, int cell, Direction dir, int len) const
+{
+    int step = (dir == HORIZONTAL ? 1 : m_cols);
+    for (int i = 0; i < len; i++)
+    {
+        pb.blocked[cell + i * step] = true;
+        pb.required[cell + i * step] = false;
+    }
+}
+
+//*********************************************************************
+//  Counting
+//*********************************************************************
+
+/**
+    Counts the layouts of a problem with one of its ships in each of its places
+    The places are independent problems, so they are spread over the pool
+ 
+    @param1 pb The problem
+    @param2 k Which of the problem's ships to place
+    @param3 pool The pool to use, or nullptr to count on this thread
+    @return Every place the ship may take, with the number of layouts that put it there
+ */
+vector<LayoutCounter::PlaceCount> LayoutCounter::countPlaces(const Problem& pb, int k, ThreadPool* pool) const
+{
+    int len = m_lengths[pb.ships[k]];
+    vector<PlaceCount> places;
+    for (int cell = 0; cell < m_rows * m_cols; cell++)
+        for (int d = 0; d < (len == 1 ? 1 : 2); d++)
+        {
+            Direction dir = (d == 0 ? HORIZONTAL : VERTICAL);
+            if (spanOk(pb, cell, dir, len))
+                places.push_back(PlaceCount{ShipPlacement{Point(cell / m_cols, cell % m_cols), dir}, 0});
+        }
+    
+    auto countRange = [&](int, long begin, long end)
+    {
+        for (long i = begin; i < end; i++)
+        {
+            const ShipPlacement& sp = places[i].place;
+            Problem rest = pb;
+            rest.ships.erase(rest.ships.begin() + k);
+            claim(rest, sp.topOrLeft.r * m_cols + sp.topOrLeft.c, sp.dir, len);
+            places[i].count = countProfile(rest);
+        }
+    };
+    if (pool != nullptr)
+        pool->parallelFor(places.size(), 1, countRange);
+    else
+        countRange(0, 0, places.size());
+    return places;
+}
+
+/**
+    Counts a problem with a broken-profile dynamic program over the cells in row-major order
+    The state after each cell is the set of ships used so far, how much of the
+    horizontal ship in progress is still to come, and for every column how much
+    of the vertical ship in progress there is still to come.  A ship is started
+    only at its top or left cell, where its whole span is checked at once.
+    Ships of equal length are started in id order and the count scaled up
+    afterwards, which keeps only one of each set of mirror states.
+    Falls back to a search when the state does not fit in 64 bits.
+ 
+    @param1 pb The problem
+    @return The number of layouts
+ */
+unsigned long long LayoutCounter::countProfile(const Problem& pb) const
+{
+    int nCells = m_rows * m_cols;
+    int n = pb.ships.size();
+    int maxLen = 0;
+    for (int id : pb.ships)
+        maxLen = max(maxLen, m_lengths[id]);
+    const int hShift = 3 * m_cols;
+    const int usedShift = hShift + 3;
+    if (maxLen > 8 || usedShift + n > 64)
+    {
+        vector<char> occ(nCells, false);
+        return countSearch(pb, 0, occ);
+    }
+    
+    // Where each ship may start, and which ships must wait for an equal earlier one
+    vector<vector<char>> okH(n), okV(n);
+    vector<int> waitFor(n, -1);
+    unsigned long long scale = 1;
+    for (int k = 0; k < n; k++)
+    {
+        int len = m_lengths[pb.ships[k]];
+        okH[k].resize(nCells);
+        okV[k].resize(nCells);
+        for (int cell = 0; cell < nCells; cell++)
+        {
+            okH[k][cell] = spanOk(pb, cell, HORIZONTAL, len);
+            okV[k][cell] = len > 1 && spanOk(pb, cell, VERTICAL, len);
+        }
+        int equal = 1;
+        for (int j = k - 1; j >= 0; j--)
+            if (m_lengths[pb.ships[j]] == len)
+            {
+                if (waitFor[k] < 0)
+                    waitFor[k] = j;
+                equal++;
+            }
+        scale *= equal;
+    }
+    
+    CountTable cur, next;
+    cur.add(0, 1);
+    for (int cell = 0; cell < nCells && cur.size() != 0; cell++)
+    {
+        int vShift = 3 * (cell % m_cols);
+        next.clear();
+        cur.forEach([&](uint64_t key, unsigned long long count)
+        {
+            int v = (key >> vShift) & 7;
+            int h = (key >> hShift) & 7;
+            if (v != 0 && h != 0)
+                return;
+            
+            // A ship in progress covers this cell
+            if (v != 0)
+            {
+                next.add(key - (uint64_t(1) << vShift), count);
+                return;
+            }
+            if (h != 0)
+            {
+                next.add(key - (uint64_t(1) << hShift), count);
+                return;
+            }
+            
+            // Leave the cell empty, or start an unused ship here
+            if (!pb.required[cell])
+                next.add(key, count);
+            uint64_t used = key >> usedShift;
+            for (int k = 0; k < n; k++)
+            {
+                if ((used >> k) & 1)
+                    continue;
+                if (waitFor[k] >= 0 && !((used >> waitFor[k]) & 1))
+                    continue;
+                uint64_t rest = m_lengths[pb.ships[k]] - 1;
+                uint64_t started = key | (uint64_t(1) << (usedShift + k));
+                if (okH[k][cell])
+                    next.add(started | (rest << hShift), count);
+                if (okV[k][cell])
+                    next.add(started | (rest << vShift), count);
+            }
+        });
+        swap(cur, next);
+    }
+    
+    uint64_t done = ((uint64_t(1) << n) - 1) << usedShift;
+    return cur.find(done) * scale;
+}
+
+/**
+    Counts a problem by trying every place for each ship in turn
+ 
+    @param1 pb The problem
+    @param2 k The number of ships already placed
+    @param3 occ Which cells are taken by the ships already placed
+    @return The number of layouts
+ */
+unsigned long long LayoutCounter::countSearch(const Problem& pb, int k, vector<char>& occ) const
+{
+    if (k == (int)pb.ships.size())
+    {
+        for (int cell = 0; cell < (int)occ.size(); cell++)
+            if (pb.required[cell] && !occ[cell])
+                return 0;
+        return 1;
+    }
+    int len = m_lengths[pb.ships[k]];
+    unsigned long long total = 0;
+    for (int cell = 0; cell < (int)occ.size(); cell++)
+        for (int d = 0; d < (len == 1 ? 1 : 2); d++)
+        {
+            Direction dir = (d == 0 ? HORIZONTAL : VERTICAL);
+            int step = (dir == HORIZONTAL ? 1 : m_cols);
+            if (!spanOk(pb, cell, dir, len))
+                continue;
+            int i = 0;
+            while (i < len && !occ[cell + i * step])
+                i++;
+            if (i < len)
+                continue;
+            for (i = 0; i < len; i++)
+                occ[cell + i * step] = true;
+            total += countSearch(pb, k + 1, occ);
+            for (i = 0; i < len; i++)
+                occ[cell + i * step] = false;
+        }
+    return total;
+}
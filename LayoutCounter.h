@@ -0,0 +1,75 @@
+#ifndef LAYOUTCOUNTER_INCLUDED
+#define LAYOUTCOUNTER_INCLUDED
+
+#include "globals.h"
+#include <functional>
+#include <vector>
+
+class Game;
+class ThreadPool;
+
+// Where one ship of a layout lies
+struct ShipPlacement
+{
+    Point topOrLeft;
+    Direction dir;
+};
+
+// What is known about the opponent's board
+struct LayoutConstraints
+{
+    // A sunk ship: its id, and the cell whose hit sank it
+    struct Sunk
+    {
+        int shipId;
+        Point at;
+    };
+    std::vector<Point> misses;
+    std::vector<Point> hits;
+    std::vector<Sunk> sunk;
+};
+
+// Counts or enumerates every legal layout of a game's fleet -- every way to
+// put each ship on the board as Board::placeShip would, without overlap --
+// that agrees with a set of constraints: no ship covers a miss, every hit is
+// covered, each sunk ship lies on hits only and covers the cell that sank
+// it, and no ship still afloat lies on hits only.  Ships are told apart by
+// id, so two ships of equal length swapping places is a different layout.
+class LayoutCounter
+{
+public:
+    LayoutCounter(const Game& g);
+    
+    unsigned long long count(const LayoutConstraints& c = LayoutConstraints(), int nThreads = 0) const;
+    std::vector<unsigned long long> occupancy(const LayoutConstraints& c, int nThreads = 0) const;
+    bool enumerate(const LayoutConstraints& c,
+                   const std::function<bool(const std::vector<ShipPlacement>&)>& visit) const;
+    
+private:
+    // A counting problem once the sunk ships have been given fixed places
+    struct Problem
+    {
+        std::vector<char> blocked;
+        std::vector<char> hit;
+        std::vector<char> required;
+        std::vector<int> ships;
+        std::vector<ShipPlacement> fixed;
+    };
+    struct PlaceCount
+    {
+        ShipPlacement place;
+        unsigned long long count;
+    };
+    template <class F>
+    bool forEachProblem(const LayoutConstraints& c, F f) const;
+    bool spanOk(const Problem& pb, int cell, Direction dir, int len) const;
+    void claim(Problem& pb, int cell, Direction dir, int len) const;
+    std::vector<PlaceCount> countPlaces(const Problem& pb, int k, ThreadPool* pool) const;
+    unsigned long long countProfile(const Problem& pb) const;
+    unsigned long long countSearch(const Problem& pb, int k, std::vector<char>& occ) const;
+    
+    int m_rows, m_cols;
+    std::vector<int> m_lengths;
+};
+
+#endif // LAYOUTCOUNTER_INCLUDED
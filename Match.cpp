@@ -0,0 +1,144 @@
+#include "Match.h"
+#include "Game.h"
+#include "Player.h"
+#include "globals.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+    // Keeps a test from dividing by zero when every pair so far scored the same
+    const double MINVARIANCE = 1e-3;
+
+    // Where one of the two tests stands
+    enum TestState {
+        TEST_RUNNING, TEST_ACCEPTED_EQUAL, TEST_ACCEPTED_STRONGER
+    };
+
+    // Log-likelihood ratio of mean mu1 against mu0, given n pair scores of
+    // this mean and variance -- the normal approximation of the generalized SPRT
+    double logLikelihoodRatio(long n, double mean, double variance, double mu0, double mu1)
+    {
+        return n * (mu1 - mu0) * (2 * mean - mu0 - mu1) / (2 * variance);
+    }
+
+    // Moves a running test on once its ratio crosses a bound; a finished test stays finished
+    void decide(TestState& t, double llr, double lower, double upper)
+    {
+        if (t != TEST_RUNNING)
+            return;
+        if (llr >= upper)
+            t = TEST_ACCEPTED_STRONGER;
+        else if (llr <= lower)
+            t = TEST_ACCEPTED_EQUAL;
+    }
+}
+
+/**
+    SequentialMatch constructor
+
+    @param1 nRows Number of rows of every board
+    @param2 nCols Number of columns of every board
+    @param3 addShips Adds the fleet to the game
+    @param4 type1 Player type of the first player -- as accepted by createPlayer
+    @param5 type2 Player type of the second player
+    The master seed is random until seed() is called
+ */
+SequentialMatch::SequentialMatch(int nRows, int nCols, bool (*addShips)(Game&),
+                                 string type1, string type2)
+: m_rows(nRows), m_cols(nCols), m_addShips(addShips), m_type1(type1), m_type2(type2),
+  m_seed(threadRng().next())
+{}
+
+/**
+    Plays pairs of games until the test reaches a verdict
+
+    @param1 options The error rates, the tolerance, and the limits on the number of pairs
+    Pair k is seeded from the master seed and k alone, so a match can be repeated exactly
+    @return The verdict with the tallies behind it -- MATCH_UNDECIDED if maxPairs ran out,
+            or if a player type is unknown
+ */
+MatchResult SequentialMatch::run(const MatchOptions& options) const
+{
+    MatchResult result;
+    auto start = chrono::steady_clock::now();
+    // Wald's bounds: accept "stronger" above upper, "equal" below lower.  Either
+    // direction could raise a false alarm, so each test gets half of alpha
+    double alpha = options.alpha / 2;
+    double lower = log(options.beta / (1 - alpha));
+    double upper = log((1 - options.beta) / alpha);
+
+    // One game and two players serve every game of the match
+    Game g(m_rows, m_cols);
+    m_addShips(g);
+    PlayerSlot slot1, slot2;
+    Player* p1 = slot1.create(findPlayerType(m_type1), "Player 1", g);
+    Player* p2 = slot2.create(findPlayerType(m_type2), "Player 2", g);
+    if (p1 == nullptr || p2 == nullptr)
+        return result;
+
+    // Running sums of the pair scores, for their mean and variance
+    double sum = 0, sumSquares = 0;
+    TestState first = TEST_RUNNING, second = TEST_RUNNING;
+    while (result.pairs < options.maxPairs)
+    {
+        uint64_t seed = Rng::mix(m_seed + result.pairs);
+        double pairScore = 0;
+        // Same seed both times, each player starting once
+        for (int k = 0; k < 2; k++)
+        {
+            g.seed(seed);
+            p1->reset();
+            p2->reset();
+            Player* winner = (k == 0 ? g.play(p1, p2, nullptr) : g.play(p2, p1, nullptr));
+            if (winner == p1)
+            {
+                result.wins1++;
+                pairScore += 0.5;
+            }
+            else if (winner == p2)
+                result.wins2++;
+            else
+            {
+                result.noResult++;
+                pairScore += 0.25;
+            }
+        }
+        result.pairs++;
+        sum += pairScore;
+        sumSquares += pairScore * pairScore;
+
+        long n = result.pairs;
+        double mean = sum / n;
+        double variance = max(sumSquares / n - mean * mean, MINVARIANCE);
+        result.llrFirst = logLikelihoodRatio(n, mean, variance, 0.5, 0.5 + options.delta);
+        result.llrSecond = logLikelihoodRatio(n, mean, variance, 0.5, 0.5 - options.delta);
+        if (n < options.minPairs)
+            continue;
+        decide(first, result.llrFirst, lower, upper);
+        decide(second, result.llrSecond, lower, upper);
+        if (first == TEST_ACCEPTED_STRONGER)
+            result.verdict = MATCH_FIRST_STRONGER;
+        else if (second == TEST_ACCEPTED_STRONGER)
+            result.verdict = MATCH_SECOND_STRONGER;
+        else if (first == TEST_ACCEPTED_EQUAL && second == TEST_ACCEPTED_EQUAL)
+            result.verdict = MATCH_EQUAL;
+        if (result.verdict != MATCH_UNDECIDED)
+            break;
+    }
+
+    result.games = 2 * result.pairs;
+    if (result.pairs > 0)
+    {
+        long n = result.pairs;
+        double mean = sum / n;
+        result.score = mean;
+        result.interval = 1.96 * sqrt(max(sumSquares / n - mean * mean, 0.0) / n);
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
@@ -0,0 +1,74 @@
+#ifndef MATCH_INCLUDED
+#define MATCH_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+class Game;
+
+// When a sequential match may stop, and how sure it must be
+struct MatchOptions
+{
+    // Chance of calling either player stronger when the two are equal
+    double alpha = 0.05;
+    // Chance of calling them equal when one wins delta more often than half
+    double beta = 0.05;
+    // Difference in win rate that counts as stronger -- anything closer is equal
+    double delta = 0.05;
+    // No verdict is given before this many pairs, however lopsided they look
+    long minPairs = 16;
+    // The match gives up undecided after this many pairs
+    long maxPairs = 50000;
+};
+
+enum MatchVerdict {
+    MATCH_FIRST_STRONGER, MATCH_SECOND_STRONGER, MATCH_EQUAL, MATCH_UNDECIDED
+};
+
+struct MatchResult
+{
+    MatchVerdict verdict = MATCH_UNDECIDED;
+    long pairs = 0;
+    long games = 0;
+    long wins1 = 0;
+    long wins2 = 0;
+    long noResult = 0;
+    // Share of the games the first player won, a game without result counting half,
+    // and the half-width of its 95% confidence interval
+    double score = 0;
+    double interval = 0;
+    // Log-likelihood ratios of "first stronger" and "second stronger" against "equal"
+    double llrFirst = 0;
+    double llrSecond = 0;
+    double seconds = 0;
+};
+
+// Plays pairs of games between two player types until a sequential
+// probability ratio test can tell whether one is stronger.  Both games of
+// a pair get the same seed, and each player starts one of them, so who
+// moves first and the luck of the draw cancel out within the pair.
+//
+// Two tests run side by side on the pair scores: a win rate of 0.5 for
+// the first player against 0.5 + delta, and against 0.5 - delta.  Each
+// uses the normal approximation of the generalized SPRT, with the spread
+// measured from the pairs themselves.  The match stops when either test
+// finds a player stronger, or when both find the players equal within
+// delta.  The two tests share alpha between them, so calling equal players
+// unequal has a chance of about alpha, and missing a difference of delta
+// a chance of about beta.
+class SequentialMatch
+{
+public:
+    SequentialMatch(int nRows, int nCols, bool (*addShips)(Game&),
+                    std::string type1, std::string type2);
+    void seed(std::uint64_t s) { m_seed = s; }
+    MatchResult run(const MatchOptions& options = MatchOptions()) const;
+
+private:
+    int m_rows, m_cols;
+    bool (*m_addShips)(Game&);
+    std::string m_type1, m_type2;
+    std::uint64_t m_seed;
+};
+
+#endif // MATCH_INCLUDED
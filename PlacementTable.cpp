@@ -0,0 +1,110 @@
+#include "PlacementTable.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+using namespace std;
+
+/**
+    Returns the table of a board size and fleet, building it on first use
+ 
+    @param1 nRows Number of rows of the board
+    @param2 nCols Number of columns of the board
+    @param3 shipLengths Length of every ship of the fleet, in any order
+    @return The table shared by every caller asking for the same geometry
+    Tables are kept for the life of the program -- a run sees only a handful of geometries
+ */
+shared_ptr<const PlacementTable> PlacementTable::get(int nRows, int nCols, const vector<int>& shipLengths)
+{
+    static mutex lock;
+    static map<tuple<int, int, vector<int> >, shared_ptr<const PlacementTable> > tables;
+    
+    vector<int> lengths = shipLengths;
+    sort(lengths.begin(), lengths.end());
+    auto key = make_tuple(nRows, nCols, lengths);
+    lock_guard<mutex> guard(lock);
+    shared_ptr<const PlacementTable>& table = tables[key];
+    if (table == nullptr)
+        table.reset(new PlacementTable(nRows, nCols, lengths));
+    return table;
+}
+
+/**
+    PlacementTable constructor
+ 
+    @param1 nRows Number of rows of the board
+    @param2 nCols Number of columns of the board
+    @param3 sortedLengths Length of every ship of the fleet, shortest first
+    Lists every horizontal and vertical placement of each distinct length and indexes them by cell
+ */
+PlacementTable::PlacementTable(int nRows, int nCols, const vector<int>& sortedLengths)
+: m_rows(nRows), m_cols(nCols)
+{
+    int nCells = nRows * nCols;
+    for (size_t i = 0; i < sortedLengths.size(); i++)
+    {
+        // Ships of equal length share one class
+        if (!m_classes.empty() && m_classes.back().m_len == sortedLengths[i])
+        {
+            m_classes.back().m_nShips++;
+            continue;
+        }
+        m_classes.push_back(LengthClass());
+        LengthClass& lc = m_classes.back();
+        lc.m_len = sortedLengths[i];
+        lc.m_nShips = 1;
+        lc.m_at.assign(2 * nCells, -1);
+        vector<int> perCell(nCells + 1, 0);
+        for (int dir = HORIZONTAL; dir <= VERTICAL; dir++)
+        {
+            // A ship of length 1 is the same either way, so only list it once
+            if (dir == VERTICAL && lc.m_len == 1)
+                break;
+            int step = (dir == HORIZONTAL ? 1 : nCols);
+            for (int r = 0; r + (dir == VERTICAL ? lc.m_len : 1) <= nRows; r++)
+                for (int c = 0; c + (dir == HORIZONTAL ? lc.m_len : 1) <= nCols; c++)
+                {
+                    int pl = static_cast<int>(lc.m_start.size());
+                    lc.m_start.push_back(r * nCols + c);
+                    lc.m_step.push_back(step);
+                    lc.m_at[r * nCols + c + (dir == VERTICAL ? nCells : 0)] = pl;
+                    for (int k = 0; k < lc.m_len; k++)
+                        perCell[r * nCols + c + k * step + 1]++;
+                }
+        }
+        if (lc.m_len == 1)
+            copy(lc.m_at.begin(), lc.m_at.begin() + nCells, lc.m_at.begin() + nCells);
+        
+        // Index the placements by the cells they cover
+        for (int cell = 0; cell < nCells; cell++)
+            perCell[cell + 1] += perCell[cell];
+        lc.m_byCellStart = perCell;
+        lc.m_byCell.resize(perCell.back());
+        for (int pl = 0; pl < static_cast<int>(lc.m_start.size()); pl++)
+            for (int k = 0; k < lc.m_len; k++)
+                lc.m_byCell[perCell[lc.m_start[pl] + k * lc.m_step[pl]]++] = pl;
+        
+        if (hasMasks())
+        {
+            lc.m_mask.resize(lc.m_start.size());
+            for (int pl = 0; pl < static_cast<int>(lc.m_start.size()); pl++)
+                for (int k = 0; k < lc.m_len; k++)
+                    lc.m_mask[pl].set(lc.m_start[pl] + k * lc.m_step[pl]);
+        }
+    }
+}
+
+/**
+    Finds the class of a ship length
+ 
+    @param1 len The length
+    @return Its index among the distinct lengths, or -1 if no ship has that length
+ */
+int PlacementTable::lengthIndex(int len) const
+{
+    for (int li = 0; li < nLengths(); li++)
+        if (m_classes[li].m_len == len)
+            return li;
+    return -1;
+}
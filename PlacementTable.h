@@ -0,0 +1,72 @@
+#ifndef PLACEMENTTABLE_INCLUDED
+#define PLACEMENTTABLE_INCLUDED
+
+#include "CellMask.h"
+#include "globals.h"
+#include <memory>
+#include <vector>
+
+// Every way a ship of each of a fleet's lengths fits on an empty board of
+// one size, indexed by the cells it covers.  A table never changes once
+// built, so get() builds each geometry's table once and hands the same one
+// to every game, board and player of that geometry, on any thread.
+//
+// Placements are grouped by distinct length, shortest first.  Within a
+// length, horizontal placements come first, then vertical ones, each in
+// row-major order of their top or left cell; a ship of length 1 is listed
+// only once.
+class PlacementTable
+{
+public:
+    static std::shared_ptr<const PlacementTable> get(int nRows, int nCols, const std::vector<int>& shipLengths);
+    
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int nLengths() const { return static_cast<int>(m_classes.size()); }
+    int length(int li) const { return m_classes[li].m_len; }
+    int nShips(int li) const { return m_classes[li].m_nShips; }
+    int lengthIndex(int len) const;
+    
+    // The placements of one length, by index
+    int nPlacements(int li) const { return static_cast<int>(m_classes[li].m_start.size()); }
+    int start(int li, int pl) const { return m_classes[li].m_start[pl]; }
+    int step(int li, int pl) const { return m_classes[li].m_step[pl]; }
+    // Only boards of at most MASKCELLS cells have masks
+    bool hasMasks() const { return m_rows * m_cols <= MASKCELLS; }
+    const CellMask& mask(int li, int pl) const { return m_classes[li].m_mask[pl]; }
+    
+    // The placements of one length covering a cell: through(li, cell)[0 .. nThrough(li, cell))
+    int nThrough(int li, int cell) const
+    {
+        return m_classes[li].m_byCellStart[cell + 1] - m_classes[li].m_byCellStart[cell];
+    }
+    const int* through(int li, int cell) const
+    {
+        return m_classes[li].m_byCell.data() + m_classes[li].m_byCellStart[cell];
+    }
+    
+    // The placement with its top or left cell at cell, or -1 if it does not fit
+    int placementAt(int li, int cell, Direction dir) const
+    {
+        return m_classes[li].m_at[dir == HORIZONTAL ? cell : cell + m_rows * m_cols];
+    }
+    
+private:
+    PlacementTable(int nRows, int nCols, const std::vector<int>& sortedLengths);
+    
+    // Every placement of one ship length
+    struct LengthClass
+    {
+        int m_len;
+        int m_nShips;
+        std::vector<int> m_start, m_step;
+        std::vector<CellMask> m_mask;
+        std::vector<int> m_byCellStart, m_byCell;
+        std::vector<int> m_at;
+    };
+    
+    int m_rows, m_cols;
+    std::vector<LengthClass> m_classes;
+};
+
+#endif // PLACEMENTTABLE_INCLUDED
@@ -1,27 +1,154 @@
 #include "Player.h"
 #include "Board.h"
 #include "Game.h"
+#include "CellMask.h"
+#include "Heatmap.h"
+#include "Instrument.h"
+#include "PlacementTable.h"
+#include "ThreadPool.h"
 #include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <stack>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 using namespace std;
 
-/**
-    Remove a specified point from a vector of points
- 
-    @param1 p The to-be-removed point
-    @param2 v The vector to remove the point from
- */
-void removePoint(Point p, vector<Point>& v)
+// Boards with more cells than this are tracked sparsely by the AI players
+const int MAXDENSECELLS = 65536;
+
+// A player's record of what it knows about each cell: '.' for nothing yet,
+// otherwise whatever mark the player chose.  Small boards use a flat array;
+// large ones only store the cells that have been marked.
+class CellMarks
 {
-    for (int i = 0; i < v.size(); i++)
+public:
+    CellMarks(const Game& g)
+    : m_rows(g.rows()), m_cols(g.cols()), m_dense(g.rows() * g.cols() <= MAXDENSECELLS)
     {
-        if (v[i].r == p.r && v[i].c == p.c)
-            v.erase(v.begin() + i);
+        if (m_dense)
+            m_cells.assign(m_rows * m_cols, '.');
     }
-}
+    
+    // Forget every mark
+    void clear()
+    {
+        if (m_dense)
+            fill(m_cells.begin(), m_cells.end(), '.');
+        else
+            m_marks.clear();
+    }
+    
+    char get(int r, int c) const
+    {
+        if (m_dense)
+            return m_cells[r * m_cols + c];
+        auto it = m_marks.find(r * m_cols + c);
+        return it == m_marks.end() ? '.' : it->second;
+    }
+    
+    void set(int r, int c, char mark)
+    {
+        if (m_dense)
+            m_cells[r * m_cols + c] = mark;
+        else
+            m_marks[r * m_cols + c] = mark;
+    }
+    
+private:
+    int m_rows, m_cols;
+    bool m_dense;
+    vector<char> m_cells;
+    unordered_map<int, char> m_marks;
+};
+
+// The cells a player has not chosen yet, with O(1) random pick, removal
+// and membership test.  Small boards keep the remaining cells in a dense
+// array plus each cell's position in it, so removal swaps the last cell
+// into the hole.  Large boards only remember the removed cells and pick
+// by rejection, which stays cheap while most of the board is untouched.
+class CellPool
+{
+public:
+    CellPool(const Game& g)
+    : m_rows(g.rows()), m_cols(g.cols()), m_dense(g.rows() * g.cols() <= MAXDENSECELLS)
+    {
+        reset();
+    }
+    
+    // Put every cell back
+    void reset()
+    {
+        m_removed.clear();
+        if (!m_dense)
+            return;
+        m_cells.resize(m_rows * m_cols);
+        m_pos.resize(m_rows * m_cols);
+        for (int i = 0; i < m_rows * m_cols; i++)
+            m_cells[i] = m_pos[i] = i;
+    }
+    
+    int size() const
+    {
+        return m_dense ? static_cast<int>(m_cells.size()) : m_rows * m_cols - static_cast<int>(m_removed.size());
+    }
+    bool empty() const { return size() == 0; }
+    
+    bool contains(Point p) const
+    {
+        int cell = p.r * m_cols + p.c;
+        return m_dense ? m_pos[cell] >= 0 : m_removed.count(cell) == 0;
+    }
+    
+    void remove(Point p)
+    {
+        if (!contains(p))
+            return;
+        int cell = p.r * m_cols + p.c;
+        if (!m_dense)
+        {
+            m_removed.insert(cell);
+            return;
+        }
+        // Swap the last remaining cell into the hole
+        int last = m_cells.back();
+        m_cells[m_pos[cell]] = last;
+        m_pos[last] = m_pos[cell];
+        m_cells.pop_back();
+        m_pos[cell] = -1;
+    }
+    
+    // Returns a uniformly chosen remaining cell -- the pool must not be empty
+    Point random(Rng& rng) const
+    {
+        if (m_dense)
+        {
+            int cell = m_cells[rng.randInt(m_cells.size())];
+            return Point(cell / m_cols, cell % m_cols);
+        }
+        for (;;)
+        {
+            Point p(rng.randInt(m_rows), rng.randInt(m_cols));
+            if (contains(p))
+                return p;
+        }
+    }
+    
+private:
+    int m_rows, m_cols;
+    bool m_dense;
+    // Dense: the remaining cells, and each cell's index in m_cells or -1
+    vector<int> m_cells, m_pos;
+    // Sparse: the removed cells
+    unordered_set<int> m_removed;
+};
 
 //*********************************************************************
 //  AwfulPlayer
@@ -31,12 +158,16 @@ class AwfulPlayer : public Player
 {
 public:
     // Constructor
-    AwfulPlayer(string nm, const Game& g);
+    AwfulPlayer(string_view nm, const Game& g);
     
     // Destructror
     virtual ~AwfulPlayer() {}
     
+    // Accessor
+    virtual const char* typeName() const { return "awful"; }
+    
     // Other
+    virtual void reset() { m_lastCellAttacked = Point(0, 0); }
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
@@ -49,7 +180,7 @@ private:
 /**
     Awful Player constructor
  */
-AwfulPlayer::AwfulPlayer(string nm, const Game& g)
+AwfulPlayer::AwfulPlayer(string_view nm, const Game& g)
 : Player(nm, g), m_lastCellAttacked(0, 0)
 {}
 
@@ -105,15 +236,17 @@ class HumanPlayer : public Player
 {
 public:
     // Constructor
-    HumanPlayer(string nm, const Game& g) : Player(nm, g) {}
+    HumanPlayer(string_view nm, const Game& g) : Player(nm, g) {}
     
     // Destructor
     virtual ~HumanPlayer() {}
     
     // Accessor
     virtual bool isHuman() const { return true; }
+    virtual const char* typeName() const { return "human"; }
     
     // Other
+    virtual void reset() { /* nothing to forget */ }
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId) { /* do nothing */ }
@@ -202,19 +335,23 @@ class MediocrePlayer : public Player
 {
 public:
     // Constructor
-    MediocrePlayer(string nm, const Game& g);
+    MediocrePlayer(string_view nm, const Game& g);
     
     // Destructor
     ~MediocrePlayer() {}
     
+    // Accessor
+    virtual const char* typeName() const { return "mediocre"; }
+    
     // Other
+    virtual void reset();
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p) { /* do nothing */ }
     
     // Helper functions
-    bool auxPlaceShips(Board& b, int shipsLeft, int r, int c, int id, bool backTrack, vector<Point> added, vector<Direction> dirs);
+    bool auxPlaceShips(Board& b);
     Point calculateShot();
     void buildCalculatedPoints(Point p);
     
@@ -224,13 +361,16 @@ private:
     // Stores state of player -- two states: randomly firing and calculated firing
     int m_state;
     // Stores the points available on the board to shoot
-    vector<Point> m_points;
+    CellPool m_points;
     // Stores the calculated points available when set to state 2
     vector<Point> m_calculatedPoints;
     // Stores history of shots -- misses and hits
-    vector<vector<char> > m_hist;
+    CellMarks m_hist;
     // Allows the player to know when to build the calculated points
     bool buildCPoints;
+    // Placement stack of auxPlaceShips -- where and how each placed ship lies
+    vector<Point> m_placedAt;
+    vector<Direction> m_placedDir;
 };
 
 /**
@@ -239,19 +379,24 @@ private:
     Initializes m_points to all the points on the board
     Initializes m_hist to blank i.e. all '.'s
  */
-MediocrePlayer::MediocrePlayer(string nm, const Game& g)
-: Player(nm, g), m_state(1), m_lastCellHit(0, 0), m_calculatedPoints({}), buildCPoints(false)
+MediocrePlayer::MediocrePlayer(string_view nm, const Game& g)
+: Player(nm, g), m_state(1), m_lastCellHit(0, 0), m_points(g), m_calculatedPoints({}), m_hist(g), buildCPoints(false),
+  m_placedAt(g.nShips()), m_placedDir(g.nShips())
+{}
+
+/**
+    Resets Mediocre Player for a new game
+ 
+    Every cell is available and unmarked again; the vectors keep their storage
+ */
+void MediocrePlayer::reset()
 {
-    m_hist.resize(game().rows());
-    for (int r = 0; r < game().rows(); r++)
-    {
-        m_hist[r].resize(game().cols());
-        for (int c = 0; c < game().cols(); c++)
-        {
-            m_points.push_back(Point(r,c));
-            m_hist[r][c] = '.';
-        }
-    }
+    m_state = 1;
+    m_lastCellHit = Point(0, 0);
+    m_points.reset();
+    m_calculatedPoints.clear();
+    m_hist.clear();
+    buildCPoints = false;
 }
 
 /**
@@ -259,7 +404,7 @@ MediocrePlayer::MediocrePlayer(string nm, const Game& g)
  
     @param1 b The board to place ships on
     Mediocre Players block ~50% of the map before placing ships
-    Use recursive algorithm to place the ships
+    Use backtracking algorithm to place the ships
     Unblocks the board before returning
  */
 bool MediocrePlayer::placeShips(Board& b)
@@ -271,106 +416,74 @@ bool MediocrePlayer::placeShips(Board& b)
     {
         // Block ~50% of board before placement
         b.block();
-        valid = auxPlaceShips(b, game().nShips(), 0, 0, 0, false, {}, {});
+        valid = auxPlaceShips(b);
         // Unblock board after attempting to place
         b.unblock();
         counter++;
     }
+    instrumentCount(*this, COUNT_PLACEMENTRETRIES, counter - 1);
+    if (!valid)
+        instrumentCount(*this, COUNT_PLACEMENTFAILURES);
     return valid;
 }
 
 /**
     Auxillary function for Mediocre Player to place ships
  
-    @param1 b The board to place ships on
-    @param2 shipsLeft The number of ships left to be placed
-    @param3 r The starting row for the algorithm
-    @param4 c The starting column for the algorithm
-    @param5 id The id of the ship currently being placed
-    @param5 backTrack True if ship does not fit and needs to unplace the last ship placed
-    @param6 added Vector storing the topmost of leftmost points of ships added to the board
-    @param7 dirs Vector storing the directionns of ships added to the board
- 
-    This is a recursive function that places ships on the board. It recursively iterates through the board
-    attempting to place ships (either HORIZONTALLy or VERTICALLY) whenever possible. If it reaches the end
-    of the board and all ships have not yet been placed, it backTracks by unplacing the last placed ship.
-    It will do this until it unplaces the first ship if need be. This is all performed by recursively calling
-    itself with updated parameters.
- */
-bool MediocrePlayer::auxPlaceShips(Board& b, int shipsLeft, int r, int c, int id, bool backTrack, vector<Point> added, vector<Direction> dirs)
-{
-    // Set to true if ship is placed false otherwise
-    bool valid;
-    
-    // Base Case 1: If all ships placed our job is done
-    if (shipsLeft == 0) return true;
-    // If c exceeds game columns set it to 0 and increment row count
-    if (c > game().cols()-1)
-    {
-        c = 0;
-        r++;
-    }
-    // Base Case 2: If r exceeds game rows start backtracking
-    if (r > game().rows()-1 && c == 0) backTrack = true;
-    // Base Case 3: If no ships in added and backtrack is true return false -- no viable arrangment for ships
-    if (added.size() == 0 && backTrack) return false;
-    
-    // If not backtracking
-    if (!backTrack)
+    @param1 b The board to place ships on -- already blocked
+    @return True if every ship was placed
+ 
+    Backtracking search with an explicit stack: ship id is tried at each cell in row-major order,
+    horizontally and then vertically, and on success the next ship starts again from the top left.
+    If a ship reaches the end of the board, the previous ship is unplaced and resumes from just
+    after where it was. The stack holds one entry per placed ship, lives in m_placedAt/m_placedDir
+    sized once in the constructor, and the board's bit masks do the fit checks, so an attempt
+    allocates nothing.
+ */
+bool MediocrePlayer::auxPlaceShips(Board& b)
+{
+    int nCells = game().rows() * game().cols();
+    int id = 0;
+    // Next cell to try for ship id, and whether horizontal was already tried there
+    int cell = 0;
+    bool skipHorizontal = false;
+    while (id < game().nShips())
     {
-        // Attempt to place ship horizontally
-        valid = b.placeShip(Point(r, c), id, HORIZONTAL);
-        // If successfully placed horizontally
-        if (valid)
+        // Ship id fits nowhere -- backtrack to the previous ship, or give up if there is none
+        if (cell >= nCells)
         {
-            // Add point of placement
-            added.push_back(Point(r,c));
-            // Add direction or placedment
-            dirs.push_back(HORIZONTAL);
-            // Recursively call with adjusted parameters
-            return auxPlaceShips(b, shipsLeft-1, 0, 0, id+1, backTrack, added, dirs);
+            if (id == 0)
+                return false;
+            id--;
+            b.unplaceShip(m_placedAt[id], id, m_placedDir[id]);
+            cell = m_placedAt[id].r * game().cols() + m_placedAt[id].c;
+            // After horizontal, vertical is still untried at the same cell
+            skipHorizontal = (m_placedDir[id] == HORIZONTAL);
+            if (!skipHorizontal)
+                cell++;
+            continue;
         }
-        // Cannot place ship horizontally
-        else
+        Point p(cell / game().cols(), cell % game().cols());
+        Direction dir = HORIZONTAL;
+        bool placed = !skipHorizontal && b.placeShip(p, id, HORIZONTAL);
+        if (!placed)
         {
-            // Attempt to place ship vertically
-            valid = b.placeShip(Point(r, c), id, VERTICAL);
-            // If successfully placed vertically
-            if (valid)
-            {
-                // Add points of placement
-                added.push_back(Point(r,c));
-                // Add direction of placement
-                dirs.push_back(VERTICAL);
-                // Recursively call with adjusted parameters
-                return auxPlaceShips(b, shipsLeft-1, 0, 0, id+1, backTrack, added, dirs);
-            }
-            // Not able to place horizontally or vertically
-            else
-            {
-                // Recursively call with updated parameters -- only increment column
-                return auxPlaceShips(b, shipsLeft, r, c+1, id, backTrack, added, dirs);
-            }
+            dir = VERTICAL;
+            placed = b.placeShip(p, id, VERTICAL);
         }
+        skipHorizontal = false;
+        if (!placed)
+        {
+            cell++;
+            continue;
+        }
+        // Push the placement and start the next ship from the top left
+        m_placedAt[id] = p;
+        m_placedDir[id] = dir;
+        id++;
+        cell = 0;
     }
-    else // backtracking
-    {
-        // Get row and column of last added ship
-        r = added.back().r;
-        c = added.back().c;
-        // Get direction of last added ship
-        Direction dir = dirs.back();
-        // Remove ship from added
-        added.pop_back();
-        // Remove direciton from added
-        dirs.pop_back();
-        // Unplace ship
-        valid = b.unplaceShip(Point(r, c), id-1, dir);
-        // No longer backtracking
-        backTrack = false;
-        // Recursively call with updated parameters -- increment shipsLeft, columns, decrement id
-        return auxPlaceShips(b, shipsLeft+1, r, c+1, id-1, backTrack, added, dirs);
-    }
+    return true;
 }
 
 /**
@@ -386,21 +499,23 @@ Point MediocrePlayer::recommendAttack()
 {
     // m_points should not be empty
     if (m_points.empty())
+    {
         cerr << "Error MediocrePlayer::recommendAttack() -- someone should have one" << endl;
+        return Point(0, 0);
+    }
     // Randomly select point on board to shoot
     if (m_state == 1)
     {
         // Randomly select point from points
-        int i = randInt(m_points.size());
-        Point p(m_points[i].r, m_points[i].c);
-        removePoint(p, m_points);
+        Point p = m_points.random(game().rng());
+        m_points.remove(p);
         return p;
     }
     // Select point randomly from calculated points
     else // state 2
     {
         Point p = calculateShot();
-        removePoint(p, m_points);
+        m_points.remove(p);
         return p;
     }
 }
@@ -418,9 +533,9 @@ void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, b
 {
     // If shot hit mark it in players data members
     if (shotHit)
-        m_hist[p.r][p.c] = 'X';
+        m_hist.set(p.r, p.c, 'X');
     else
-        m_hist[p.r][p.c] = 'o';
+        m_hist.set(p.r, p.c, 'o');
     
     if (!validShot)
         cerr << "Error MediocrePlayer::recordAttackResult -- computer should not be shooting invalid shots" << endl;
@@ -453,9 +568,11 @@ Point MediocrePlayer::calculateShot()
 {
     if (buildCPoints)
         buildCalculatedPoints(m_lastCellHit);
-    int i = randInt(m_calculatedPoints.size());
-    Point r(m_calculatedPoints[i].r, m_calculatedPoints[i].c);
-    removePoint(r, m_calculatedPoints);
+    int i = game().rng().randInt(m_calculatedPoints.size());
+    Point r = m_calculatedPoints[i];
+    // Order does not matter, so move the last point into the hole
+    m_calculatedPoints[i] = m_calculatedPoints.back();
+    m_calculatedPoints.pop_back();
     if (m_calculatedPoints.empty())
         m_state = 1;
     return r;
@@ -473,16 +590,17 @@ void MediocrePlayer::buildCalculatedPoints(Point p)
     // Check points for validity and add them to vector
     for (int d = 1; d < 5; d++)
     {
-        if (p.r-d >= 0 && m_hist[p.r-d][p.c] == '.')
+        if (p.r-d >= 0 && m_hist.get(p.r-d, p.c) == '.')
             m_calculatedPoints.push_back(Point(p.r-d, p.c));
-        if (p.r+d <= game().rows()-1 && m_hist[p.r+d][p.c] == '.')
+        if (p.r+d <= game().rows()-1 && m_hist.get(p.r+d, p.c) == '.')
             m_calculatedPoints.push_back(Point(p.r+d, p.c));
-        if (p.c-d >= 0 && m_hist[p.r][p.c-d] == '.')
+        if (p.c-d >= 0 && m_hist.get(p.r, p.c-d) == '.')
             m_calculatedPoints.push_back(Point(p.r, p.c-d));
-        if (p.c+d <= game().cols()-1 && m_hist[p.r][p.c+d] == '.')
+        if (p.c+d <= game().cols()-1 && m_hist.get(p.r, p.c+d) == '.')
             m_calculatedPoints.push_back(Point(p.r, p.c+d));
     }
     buildCPoints = false;
+    instrumentRecord(*this, SIZE_TARGETQUEUE, m_calculatedPoints.size());
 }
 
 
@@ -495,12 +613,16 @@ class GoodPlayer : public Player
 {
 public:
     // Constructor
-    GoodPlayer(string nm, const Game& g);
+    GoodPlayer(string_view nm, const Game& g);
     
     // Destructor
     ~GoodPlayer() {}
     
+    // Accessor
+    virtual const char* typeName() const { return "good"; }
+    
     // Other
+    virtual void reset();
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
@@ -511,13 +633,13 @@ public:
     
 private:
     // Stores points left on the board
-    vector<Point> m_points;
+    CellPool m_points;
     // State of the player -- randomly firing and shooting surrounding cells
     int m_state;
-    // Stack storing the points surrounding a hit attack
-    stack<Point> m_attackPoints;
+    // Stack storing the points surrounding a hit attack -- a vector, so reset keeps its storage
+    vector<Point> m_attackPoints;
     // Stores history of shots -- misses and hits
-    vector<vector<char> > m_hist;
+    CellMarks m_hist;
 };
 
 /** 
@@ -525,19 +647,19 @@ private:
  
     Initializes m_hist to empty board and m_points with all points on the board
  */
-GoodPlayer::GoodPlayer(string nm, const Game& g)
-: Player(nm, g), m_state(1)
+GoodPlayer::GoodPlayer(string_view nm, const Game& g)
+: Player(nm, g), m_points(g), m_state(1), m_hist(g)
+{}
+
+/**
+    Resets Good Player for a new game
+ */
+void GoodPlayer::reset()
 {
-    m_hist.resize(game().rows());
-    for (int r = 0; r < game().rows(); r++)
-    {
-        m_hist[r].resize(game().cols());
-        for (int c = 0; c < game().cols(); c++)
-        {
-            m_points.push_back(Point(r,c));
-            m_hist[r][c] = '.';
-        }
-    }
+    m_points.reset();
+    m_state = 1;
+    m_attackPoints.clear();
+    m_hist.clear();
 }
 
 /**
@@ -552,23 +674,19 @@ bool GoodPlayer::placeShips(Board& b)
     int shipsLeft = game().nShips();
     while (shipsLeft > 0)
     {
-        int i = randInt(m_points.size());
-        Point p(m_points[i].r, m_points[i].c);
+        Point p = m_points.random(game().rng());
         valid = b.placeShip(p, id, HORIZONTAL);
         if (!valid)
             valid = b.placeShip(p, id, VERTICAL);
         if (valid)
         {
-            removePoint(p, m_points);
+            m_points.remove(p);
             shipsLeft--;
             id++;
         }
     }
-    // Once ships are placed clear points and reinitiate them for attacking phase
-    m_points.clear();
-    for (int r = 0; r < game().rows(); r++)
-        for (int c = 0; c < game().cols(); c++)
-            m_points.push_back(Point(r,c));
+    // Once ships are placed reinitiate points for attacking phase
+    m_points.reset();
     return true;
 }
 
@@ -584,10 +702,9 @@ Point GoodPlayer::recommendAttack()
     if (m_state == 1)
     {
         // Randomly select point from points
-        int i = randInt(m_points.size());
-        Point p(m_points[i].r, m_points[i].c);
+        Point p = m_points.random(game().rng());
         // Remove the selected point from points remaining
-        removePoint(p, m_points);
+        m_points.remove(p);
         return p;
     }
     // Attack the next point on the stack
@@ -595,13 +712,13 @@ Point GoodPlayer::recommendAttack()
     {
         Point attack;
         if (!m_attackPoints.empty())
-            attack = m_attackPoints.top();
+            attack = m_attackPoints.back();
         // Make sure stack is not empty
         else
             cerr << "Error GoodPlayer::recomendAttack -- stack should not be empty" << endl;
-        m_attackPoints.pop();
+        m_attackPoints.pop_back();
         // Remove the selected point from points remaining
-        removePoint(attack, m_points);
+        m_points.remove(attack);
         return attack;
     }
 }
@@ -624,12 +741,12 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool
     // If shot hit mark it and add to the stack
     if (shotHit)
     {
-        m_hist[p.r][p.c] = 'X';
+        m_hist.set(p.r, p.c, 'X');
         addAttackPoints(p);
     }
     // Mark if shot did not hit
     else
-        m_hist[p.r][p.c] = 'o';
+        m_hist.set(p.r, p.c, 'o');
     
     // Switch to state 2 if shot hit
     if (m_state == 1)
@@ -653,51 +770,790 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool
 void GoodPlayer::addAttackPoints(Point p)
 {
     // If cell above p is valid add it to the stack
-    if (p.r-1 >= 0 && m_hist[p.r-1][p.c] == '.')
+    if (p.r-1 >= 0 && m_hist.get(p.r-1, p.c) == '.')
     {
-        m_hist[p.r-1][p.c] = 'a';
-        m_attackPoints.push(Point(p.r-1, p.c));
+        m_hist.set(p.r-1, p.c, 'a');
+        m_attackPoints.push_back(Point(p.r-1, p.c));
     }
     // If cell below p is valid add it to the stack
-    if (p.r+1 <= game().rows()-1 && m_hist[p.r+1][p.c] == '.')
+    if (p.r+1 <= game().rows()-1 && m_hist.get(p.r+1, p.c) == '.')
     {
-        m_hist[p.r+1][p.c] = 'a';
-        m_attackPoints.push(Point(p.r+1, p.c));
+        m_hist.set(p.r+1, p.c, 'a');
+        m_attackPoints.push_back(Point(p.r+1, p.c));
     }
     // If cell to the left of p is valid add it to the stack
-    if (p.c-1 >= 0 && m_hist[p.r][p.c-1] == '.')
+    if (p.c-1 >= 0 && m_hist.get(p.r, p.c-1) == '.')
     {
-        m_hist[p.r][p.c-1] = 'a';
-        m_attackPoints.push(Point(p.r, p.c-1));
+        m_hist.set(p.r, p.c-1, 'a');
+        m_attackPoints.push_back(Point(p.r, p.c-1));
     }
     // If cell to the right of p is valid add it to the stack
-    if (p.c+1 <= game().cols()-1 && m_hist[p.r][p.c+1] == '.')
+    if (p.c+1 <= game().cols()-1 && m_hist.get(p.r, p.c+1) == '.')
+    {
+        m_hist.set(p.r, p.c+1, 'a');
+        m_attackPoints.push_back(Point(p.r, p.c+1));
+    }
+    instrumentRecord(*this, SIZE_TARGETQUEUE, m_attackPoints.size());
+}
+
+//*********************************************************************
+//  Shared by the DensityPlayer and the MonteCarloPlayer
+//*********************************************************************
+
+/**
+    Returns the length of every ship of a game's fleet
+ */
+vector<int> fleetLengths(const Game& g)
+{
+    vector<int> lengths;
+    for (int id = 0; id < g.nShips(); id++)
+        lengths.push_back(g.shipLength(id));
+    return lengths;
+}
+
+/**
+    Places every ship at a random cell in a random direction
+ 
+    @param1 b The board to place ships on
+    @param2 g The game, whose generator is used
+    @return True if every ship was placed
+    Random attempts come first, then a scan of the whole board so a tight fleet still fits.
+    An even spread gives opponents nothing to learn.
+ */
+bool placeShipsAtRandom(Board& b, const Game& g)
+{
+    for (int id = 0; id < g.nShips(); id++)
+    {
+        bool valid = false;
+        for (int tries = 0; !valid && tries < 1000; tries++)
+            valid = b.placeShip(g.randomPoint(), id, g.rng().randInt(2) == 0 ? HORIZONTAL : VERTICAL);
+        for (int cell = 0; !valid && cell < g.rows() * g.cols(); cell++)
+        {
+            Point p(cell / g.cols(), cell % g.cols());
+            valid = b.placeShip(p, id, HORIZONTAL) || b.placeShip(p, id, VERTICAL);
+        }
+        if (!valid)
+            return false;
+    }
+    return true;
+}
+
+// What a player has learned from its own shots: the state of every cell,
+// and the hits not yet known to belong to a sunk ship
+class ShotKnowledge
+{
+public:
+    enum CellState { UNKNOWN, MISS, HIT, SUNK };
+    
+    ShotKnowledge(const Game& g) : m_rows(g.rows()), m_cols(g.cols()), m_cells(g.rows() * g.cols(), UNKNOWN) {}
+    
+    void reset()
+    {
+        fill(m_cells.begin(), m_cells.end(), UNKNOWN);
+        m_hits.clear();
+    }
+    
+    char state(int cell) const { return m_cells[cell]; }
+    const vector<int>& unresolvedHits() const { return m_hits; }
+    void recordMiss(int cell) { m_cells[cell] = MISS; }
+    void recordHit(int cell) { m_cells[cell] = HIT; m_hits.push_back(cell); }
+    
+    /**
+        Marks the cells of a sunk ship as sunk when they can be told apart
+     
+        @param1 p The point that sank the ship
+        @param2 len The length of the sunk ship
+        @param3 onSunkCell Called with each cell that becomes sunk
+        If exactly one run of len unresolved hits passes through p, those are the ship's cells.
+        Otherwise the hits stay unresolved.
+     */
+    template <class F>
+    void resolveSunk(Point p, int len, F onSunkCell)
+    {
+        int found = 0, foundStart = 0, foundStep = 1;
+        for (int dir = HORIZONTAL; dir <= VERTICAL; dir++)
+        {
+            int step = (dir == HORIZONTAL ? 1 : m_cols);
+            int along = (dir == HORIZONTAL ? p.c : p.r);
+            int limit = (dir == HORIZONTAL ? m_cols : m_rows);
+            for (int first = max(0, along - len + 1); first <= along && first + len <= limit; first++)
+            {
+                int start = (dir == HORIZONTAL ? p.r * m_cols + first : first * m_cols + p.c);
+                bool allHits = true;
+                for (int i = 0; allHits && i < len; i++)
+                    allHits = (m_cells[start + i * step] == HIT);
+                if (allHits)
+                {
+                    found++;
+                    foundStart = start;
+                    foundStep = step;
+                }
+            }
+        }
+        if (found != 1)
+            return;
+        for (int i = 0; i < len; i++)
+        {
+            int cell = foundStart + i * foundStep;
+            m_cells[cell] = SUNK;
+            m_hits.erase(find(m_hits.begin(), m_hits.end(), cell));
+            onSunkCell(cell);
+        }
+    }
+    
+private:
+    int m_rows, m_cols;
+    vector<char> m_cells;
+    vector<int> m_hits;
+};
+
+/**
+    Returns the unknown cell with the highest score, breaking ties at random
+ 
+    @param1 know What the player knows about each cell
+    @param2 nCells Number of cells on the board
+    @param3 score Returns the score of a cell
+    @param4 rng Generator used to break ties
+    @return The chosen cell -- a random unknown cell if no cell scores above 0
+ */
+template <class F>
+int bestUnknownCell(const ShotKnowledge& know, int nCells, F score, Rng& rng)
+{
+    long long best = 0;
+    int bestCell = -1, nTied = 0;
+    for (int cell = 0; cell < nCells; cell++)
+    {
+        if (know.state(cell) != ShotKnowledge::UNKNOWN)
+            continue;
+        long long sc = score(cell);
+        if (sc > best)
+        {
+            best = sc;
+            bestCell = cell;
+            nTied = 1;
+        }
+        // Reservoir sampling keeps each tied cell with equal probability
+        else if (best > 0 && sc == best && rng.randInt(++nTied) == 0)
+            bestCell = cell;
+    }
+    // Nothing scored -- fall back to any unknown cell
+    if (bestCell < 0)
     {
-        m_hist[p.r][p.c+1] = 'a';
-        m_attackPoints.push(Point(p.r, p.c+1));
+        for (int cell = 0; cell < nCells; cell++)
+            if (know.state(cell) == ShotKnowledge::UNKNOWN && rng.randInt(++nTied) == 0)
+                bestCell = cell;
+        if (bestCell < 0)
+            bestCell = 0;
     }
+    return bestCell;
 }
 
 //*********************************************************************
-//  createPlayer
+//  DensityPlayer
 //*********************************************************************
 
-Player* createPlayer(string type, string nm, const Game& g)
+class DensityPlayer : public Player
+{
+public:
+    // Constructor
+    DensityPlayer(string_view nm, const Game& g);
+    
+    // Destructor
+    ~DensityPlayer() {}
+    
+    // Accessor
+    virtual const char* typeName() const { return "density"; }
+    
+    // Other
+    virtual void reset();
+    virtual bool placeShips(Board& b) { return placeShipsAtRandom(b, game()); }
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point /* p */) { /* do nothing */ }
+    
+    // Helpers
+    void addHitWeights();
+    
+    // The placement table and heatmap cost about 240 bytes per cell, so
+    // larger boards -- 58 MB at this size, a gigabyte at 2000 x 2000 -- are refused
+    static const long MAXCELLS = 250000;
+    
+private:
+    // A placement covering this many unresolved hits weighs HITWEIGHT^hits
+    static const long long HITWEIGHT = 64;
+    
+    int m_rows, m_cols;
+    ShotKnowledge m_know;
+    // Placements of the surviving ships, kept current shot by shot
+    Heatmap m_heatmap;
+    // Extra score of the cells covered by placements through hits, and which cells have any
+    vector<long long> m_extra;
+    vector<int> m_touched;
+};
+
+/**
+    Density Player Constructor
+ 
+    Initializes every cell to unknown and builds the heatmap of the full fleet
+ */
+DensityPlayer::DensityPlayer(string_view nm, const Game& g)
+: Player(nm, g), m_rows(g.rows()), m_cols(g.cols()),
+  m_know(g), m_heatmap(g.placements()),
+  m_extra(g.rows() * g.cols(), 0)
+{}
+
+/**
+    Resets Density Player for a new game
+ 
+    m_extra is already all zeros -- recommendAttack clears what it touches
+ */
+void DensityPlayer::reset()
 {
-    static string types[] = {
-        "human", "awful", "mediocre", "good"
+    m_know.reset();
+    m_heatmap.reset();
+}
+
+/**
+    Adds the hit bonus of every live placement through an unresolved hit to m_extra
+ 
+    A placement covering k unresolved hits weighs count * HITWEIGHT^k in total; the heatmap
+    already holds count of it, so the rest goes to each unknown cell it covers.
+    Only placements through hits are visited, each once -- from its first hit cell.
+ */
+void DensityPlayer::addHitWeights()
+{
+    for (int hit : m_know.unresolvedHits())
+    {
+        m_heatmap.forEachPlacementThrough(hit, [&](int start, int step, int len, int count)
+        {
+            long long weight = count;
+            int firstHit = -1;
+            for (int i = 0, cell = start; i < len; i++, cell += step)
+                if (m_know.state(cell) == ShotKnowledge::HIT)
+                {
+                    weight *= HITWEIGHT;
+                    if (firstHit < 0)
+                        firstHit = cell;
+                }
+            if (firstHit != hit)
+                return;
+            for (int i = 0, cell = start; i < len; i++, cell += step)
+                if (m_know.state(cell) == ShotKnowledge::UNKNOWN)
+                {
+                    if (m_extra[cell] == 0)
+                        m_touched.push_back(cell);
+                    m_extra[cell] += weight - count;
+                }
+        });
+    }
+}
+
+/**
+    recommendAttack for Density Player
+ 
+    Scores every unknown cell by the weighted number of surviving-ship placements covering it
+    and fires at the highest score, breaking ties at random
+ */
+Point DensityPlayer::recommendAttack()
+{
+    addHitWeights();
+    int cell = bestUnknownCell(m_know, m_rows * m_cols,
+                               [&](int c) { return m_heatmap.heat(c) + m_extra[c]; }, game().rng());
+    for (int c : m_touched)
+        m_extra[c] = 0;
+    m_touched.clear();
+    return Point(cell / m_cols, cell % m_cols);
+}
+
+/**
+    recordAttackResult for Density Player
+ 
+    @param1 p The point last attacked
+    @param2 validShot True if the last attack is valid
+    @param3 shotHit True if the last attack hit a ship
+    @param4 shipDestroyed True if the last attack destroyed a ship
+    @param5 shipId Id of the ship last hit
+ */
+void DensityPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (!validShot)
+    {
+        cerr << "Error DensityPlayer::recordAttackResult -- computer should not be shooting invalid shots" << endl;
+        return;
+    }
+    int cell = p.r * m_cols + p.c;
+    // A miss rules out only the placements through it
+    if (!shotHit)
+    {
+        m_know.recordMiss(cell);
+        m_heatmap.block(cell);
+        return;
+    }
+    m_know.recordHit(cell);
+    // A sunk ship no longer needs placing, and its cells no longer attract shots
+    if (shipDestroyed)
+    {
+        int len = game().shipLength(shipId);
+        m_heatmap.shipSunk(len);
+        m_know.resolveSunk(p, len, [&](int sunk) { m_heatmap.block(sunk); });
+    }
+}
+
+//*********************************************************************
+//  MonteCarloPlayer
+//*********************************************************************
+
+class MonteCarloPlayer : public Player
+{
+public:
+    // Constructor
+    MonteCarloPlayer(string_view nm, const Game& g, int nSamples = 4096);
+    
+    // Destructor
+    ~MonteCarloPlayer() {}
+    
+    // Accessor
+    virtual const char* typeName() const { return "montecarlo"; }
+    
+    // Other
+    virtual void reset();
+    virtual bool placeShips(Board& b) { return placeShipsAtRandom(b, game()); }
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point /* p */) { /* do nothing */ }
+    
+    // Helpers
+    bool sampleLayout(Rng& rng, CellMask& ships) const;
+    
+private:
+    // Samples are drawn in chunks of this many, each chunk from its own stream
+    static const int CHUNK = 256;
+    
+    int m_rows, m_cols, m_nSamples;
+    ShotKnowledge m_know;
+    // Cells no ship can cover -- misses and sunk ships -- and unresolved hits
+    CellMask m_blocked, m_hits;
+    // Every placement of every length, shared with all games of this geometry
+    shared_ptr<const PlacementTable> m_table;
+    // Length class in m_table of each surviving ship
+    vector<int> m_afloat;
+    // How many accepted samples covered each cell
+    vector<atomic<long long> > m_counts;
+};
+
+/**
+    Returns the pool every MonteCarloPlayer samples on, and the lock that keeps it to one decision at a time
+ */
+static ThreadPool& samplingPool(mutex*& lock)
+{
+    static ThreadPool pool;
+    static mutex poolLock;
+    lock = &poolLock;
+    return pool;
+}
+
+/**
+    Monte Carlo Player Constructor
+ 
+    @param3 nSamples Number of layouts sampled per decision
+ */
+MonteCarloPlayer::MonteCarloPlayer(string_view nm, const Game& g, int nSamples)
+: Player(nm, g), m_rows(g.rows()), m_cols(g.cols()), m_nSamples(nSamples), m_know(g),
+  m_table(g.placements()), m_counts(g.rows() * g.cols())
+{
+    reset();
+}
+
+/**
+    Resets Monte Carlo Player for a new game
+ 
+    The whole fleet is afloat again; m_counts is cleared by each decision
+ */
+void MonteCarloPlayer::reset()
+{
+    m_know.reset();
+    m_blocked = m_hits = CellMask();
+    m_afloat.clear();
+    for (int id = 0; id < game().nShips(); id++)
+        m_afloat.push_back(m_table->lengthIndex(game().shipLength(id)));
+}
+
+/**
+    Draws one random fleet layout consistent with the shots so far
+ 
+    @param1 rng The generator of the calling thread's stream
+    @param2 ships Set to the cells covered by the layout
+    @return True if the layout is consistent -- every unresolved hit is covered
+    Ships are laid on an internal mask with the same checks as Board::placeShip: no overlap with
+    other ships and, here, none with misses or sunk ships. Uncovered hits are served first, each
+    by a random surviving ship through it, then the rest of the fleet goes anywhere it fits.
+ */
+bool MonteCarloPlayer::sampleLayout(Rng& rng, CellMask& ships) const
+{
+    const int MAXTRIES = 32;
+    int lengths[MASKCELLS];
+    int nLeft = static_cast<int>(m_afloat.size());
+    copy(m_afloat.begin(), m_afloat.end(), lengths);
+    ships = CellMask();
+    CellMask taken = m_blocked;
+    
+    for (;;)
+    {
+        CellMask uncovered = m_hits & ~ships;
+        if (uncovered.none() || nLeft == 0)
+            break;
+        // Cover the first uncovered hit with a random surviving ship
+        int i = rng.randInt(nLeft);
+        int cell = uncovered.lowest();
+        int nOptions = m_table->nThrough(lengths[i], cell);
+        const int* options = m_table->through(lengths[i], cell);
+        if (nOptions == 0)
+            return false;
+        bool placed = false;
+        for (int t = 0; !placed && t < MAXTRIES; t++)
+        {
+            const CellMask& m = m_table->mask(lengths[i], options[rng.randInt(nOptions)]);
+            if ((m & taken).none())
+            {
+                taken |= m;
+                ships |= m;
+                placed = true;
+            }
+        }
+        if (!placed)
+            return false;
+        lengths[i] = lengths[--nLeft];
+    }
+    if ((m_hits & ~ships).any())
+        return false;
+    
+    // The rest of the fleet goes anywhere it fits
+    for (int i = 0; i < nLeft; i++)
+    {
+        int nOptions = m_table->nPlacements(lengths[i]);
+        bool placed = false;
+        for (int t = 0; !placed && t < MAXTRIES; t++)
+        {
+            const CellMask& m = m_table->mask(lengths[i], rng.randInt(nOptions));
+            if ((m & taken).none())
+            {
+                taken |= m;
+                ships |= m;
+                placed = true;
+            }
+        }
+        if (!placed)
+            return false;
+    }
+    return true;
+}
+
+/**
+    recommendAttack for Monte Carlo Player
+ 
+    Samples layouts in parallel, counts how often each cell is covered, and fires at the most covered unknown cell.
+    Chunk k of the samples always uses the stream derived from k, so the choice does not depend on the thread count.
+ */
+Point MonteCarloPlayer::recommendAttack()
+{
+    for (auto& c : m_counts)
+        c.store(0, memory_order_relaxed);
+    uint64_t base = game().rng().next();
+    int nChunks = (m_nSamples + CHUNK - 1) / CHUNK;
+    
+    auto work = [&](int, long begin, long end)
+    {
+        // Count locally, then publish with one atomic add per cell
+        long long local[MASKCELLS] = {};
+        for (long k = begin; k < end; k++)
+        {
+            Rng rng(Rng::mix(base + k));
+            int n = min<long>(CHUNK, m_nSamples - k * CHUNK);
+            for (int s = 0; s < n; s++)
+            {
+                CellMask ships;
+                if (!sampleLayout(rng, ships))
+                    continue;
+                for (uint64_t w = ships.lo(); w != 0; w &= w - 1)
+                    local[__builtin_ctzll(w)]++;
+                for (uint64_t w = ships.hi(); w != 0; w &= w - 1)
+                    local[64 + __builtin_ctzll(w)]++;
+            }
+        }
+        for (int cell = 0; cell < m_rows * m_cols; cell++)
+            if (local[cell] != 0)
+                m_counts[cell].fetch_add(local[cell], memory_order_relaxed);
     };
+    mutex* lock;
+    ThreadPool& pool = samplingPool(lock);
+    unique_lock<mutex> lk(*lock, try_to_lock);
+    // Another game is already sampling on the pool -- sample on this thread instead
+    // Passed by reference, so wrapping it in a std::function allocates nothing
+    if (lk.owns_lock())
+        pool.parallelFor(nChunks, 1, ref(work));
+    else
+        work(0, 0, nChunks);
     
-    int pos;
-    for (pos = 0; pos != sizeof(types)/sizeof(types[0])  &&
-         type != types[pos]; pos++)
-        ;
-    switch (pos)
+    int cell = bestUnknownCell(m_know, m_rows * m_cols,
+                               [&](int c) { return m_counts[c].load(memory_order_relaxed); }, game().rng());
+    return Point(cell / m_cols, cell % m_cols);
+}
+
+/**
+    recordAttackResult for Monte Carlo Player
+ 
+    @param1 p The point last attacked
+    @param2 validShot True if the last attack is valid
+    @param3 shotHit True if the last attack hit a ship
+    @param4 shipDestroyed True if the last attack destroyed a ship
+    @param5 shipId Id of the ship last hit
+ */
+void MonteCarloPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (!validShot)
     {
-        case 0:  return new HumanPlayer(nm, g);
-        case 1:  return new AwfulPlayer(nm, g);
-        case 2:  return new MediocrePlayer(nm, g);
-        case 3:  return new GoodPlayer(nm, g);
-        default: return nullptr;
+        cerr << "Error MonteCarloPlayer::recordAttackResult -- computer should not be shooting invalid shots" << endl;
+        return;
     }
+    int cell = p.r * m_cols + p.c;
+    if (!shotHit)
+    {
+        m_know.recordMiss(cell);
+        m_blocked.set(cell);
+        return;
+    }
+    m_know.recordHit(cell);
+    m_hits.set(cell);
+    // A sunk ship leaves the fleet, and once its cells can be told apart they stop counting as hits
+    if (shipDestroyed)
+    {
+        int len = game().shipLength(shipId);
+        m_afloat.erase(find(m_afloat.begin(), m_afloat.end(), m_table->lengthIndex(len)));
+        m_know.resolveSunk(p, len, [&](int sunk)
+        {
+            m_hits.reset(sunk);
+            m_blocked.set(sunk);
+        });
+    }
+}
+
+//*********************************************************************
+//  Player registry
+//*********************************************************************
+
+struct PlayerType::Entry
+{
+    string name;
+    PlayerFactory factory;
+};
+
+/**
+    Checks that a player type can play a game's board, and says so if it can't
+ 
+    @param1 g The game
+    @param2 maxCells The most cells the type handles
+    @param3 type The name of the type
+    @return True if the board has at most maxCells cells
+ */
+static bool boardFits(const Game& g, long maxCells, const char* type)
+{
+    if (static_cast<long>(g.rows()) * g.cols() <= maxCells)
+        return true;
+    cout << "The " << type << " player needs a board of at most " << maxCells << " cells" << endl;
+    return false;
+}
+
+/**
+    Returns the factory of the density type
+ 
+    Its indexes grow with the board, so boards over DensityPlayer::MAXCELLS cells get no player
+ */
+static PlayerFactory densityFactory()
+{
+    PlayerFactory f = playerFactory<DensityPlayer>();
+    f.create = [](string_view nm, const Game& g) -> Player*
+    {
+        return boardFits(g, DensityPlayer::MAXCELLS, "density") ? new DensityPlayer(nm, g) : nullptr;
+    };
+    f.createAt = [](void* storage, string_view nm, const Game& g) -> Player*
+    {
+        return boardFits(g, DensityPlayer::MAXCELLS, "density") ? new (storage) DensityPlayer(nm, g) : nullptr;
+    };
+    return f;
+}
+
+/**
+    Returns the factory of the montecarlo type
+ 
+    Sampling keeps its layouts in CellMasks, so boards over MASKCELLS cells get no player
+ */
+static PlayerFactory monteCarloFactory()
+{
+    PlayerFactory f = playerFactory<MonteCarloPlayer>();
+    f.create = [](string_view nm, const Game& g) -> Player*
+    {
+        return boardFits(g, MASKCELLS, "montecarlo") ? new MonteCarloPlayer(nm, g) : nullptr;
+    };
+    f.createAt = [](void* storage, string_view nm, const Game& g) -> Player*
+    {
+        return boardFits(g, MASKCELLS, "montecarlo") ? new (storage) MonteCarloPlayer(nm, g) : nullptr;
+    };
+    return f;
+}
+
+/**
+    Returns the registered types, and the lock that guards adding to them
+ 
+    The built-in types are registered on first use. A deque never moves its entries,
+    so a PlayerType stays valid while other types are added.
+ */
+static deque<PlayerType::Entry>& playerTypes(mutex*& lock)
+{
+    static mutex typesLock;
+    static deque<PlayerType::Entry> types = {
+        { "human", playerFactory<HumanPlayer>() },
+        { "awful", playerFactory<AwfulPlayer>() },
+        { "mediocre", playerFactory<MediocrePlayer>() },
+        { "good", playerFactory<GoodPlayer>() },
+        { "density", densityFactory() },
+        { "montecarlo", monteCarloFactory() }
+    };
+    lock = &typesLock;
+    return types;
+}
+
+/**
+    Adds a player type to the registry
+ 
+    @param1 type The name createPlayer will know it by
+    @param2 f How to build it
+    @return The new type -- or the existing one, unchanged, if the name is taken
+ */
+PlayerType registerPlayerType(string_view type, const PlayerFactory& f)
+{
+    mutex* lock;
+    deque<PlayerType::Entry>& types = playerTypes(lock);
+    lock_guard<mutex> guard(*lock);
+    for (const PlayerType::Entry& e : types)
+        if (e.name == type)
+            return PlayerType(&e);
+    types.push_back({ string(type), f });
+    return PlayerType(&types.back());
+}
+
+/**
+    Looks a player type up by name
+ 
+    @param1 type The name of the type
+    @return The type -- not valid if no type of that name is registered
+ */
+PlayerType findPlayerType(string_view type)
+{
+    mutex* lock;
+    deque<PlayerType::Entry>& types = playerTypes(lock);
+    lock_guard<mutex> guard(*lock);
+    for (const PlayerType::Entry& e : types)
+        if (e.name == type)
+            return PlayerType(&e);
+    return PlayerType();
+}
+
+string_view PlayerType::name() const
+{
+    return m_entry->name;
+}
+
+size_t PlayerType::size() const
+{
+    return m_entry->factory.size;
+}
+
+size_t PlayerType::align() const
+{
+    return m_entry->factory.align;
+}
+
+/**
+    Creates a player of this type on the heap
+ 
+    @param1 nm The player's name
+    @param2 g The game it plays
+    @return The player, to be deleted by the caller -- nullptr if the type is not valid
+            or can't play the game's board
+ */
+Player* PlayerType::create(string_view nm, const Game& g) const
+{
+    return m_entry == nullptr ? nullptr : m_entry->factory.create(nm, g);
+}
+
+/**
+    Creates a player of this type in caller-provided storage
+ 
+    @param1 storage At least size() bytes, aligned to align()
+    @param2 nm The player's name
+    @param3 g The game it plays
+    @return The player, to be destroyed by calling its destructor -- nullptr if the type is not valid
+            or can't play the game's board
+ */
+Player* PlayerType::createAt(void* storage, string_view nm, const Game& g) const
+{
+    return m_entry == nullptr ? nullptr : m_entry->factory.createAt(storage, nm, g);
+}
+
+PlayerSlot::~PlayerSlot()
+{
+    destroy();
+    if (m_storage != nullptr)
+        ::operator delete(m_storage, align_val_t(m_align));
+}
+
+/**
+    Creates a player in the slot, destroying the one it held
+ 
+    @param1 type The type of the new player
+    @param2 nm Its name
+    @param3 g The game it plays
+    @return The player, owned by the slot -- nullptr if the type is not valid
+            or can't play the game's board
+ */
+Player* PlayerSlot::create(PlayerType type, string_view nm, const Game& g)
+{
+    destroy();
+    if (!type.isValid())
+        return nullptr;
+    // Grow the storage only when this type needs more than any before it
+    if (type.size() > m_size || type.align() > m_align)
+    {
+        if (m_storage != nullptr)
+            ::operator delete(m_storage, align_val_t(m_align));
+        m_size = max(type.size(), m_size);
+        m_align = max(type.align(), max(m_align, alignof(max_align_t)));
+        m_storage = ::operator new(m_size, align_val_t(m_align));
+    }
+    m_player = type.createAt(m_storage, nm, g);
+    return m_player;
+}
+
+/**
+    Destroys the player in the slot, keeping the storage
+ */
+void PlayerSlot::destroy()
+{
+    if (m_player != nullptr)
+        m_player->~Player();
+    m_player = nullptr;
+}
+
+/**
+    Creates a player by type name
+ 
+    @param1 type The name of a registered type, e.g. "good"
+    @param2 nm The player's name
+    @param3 g The game it plays
+    @return The player, to be deleted by the caller -- nullptr for an unknown type,
+            or a type that can't play the game's board
+ */
+Player* createPlayer(string_view type, string_view nm, const Game& g)
+{
+    return findPlayerType(type).create(nm, g);
 }
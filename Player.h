@@ -1,7 +1,10 @@
 #ifndef PLAYER_INCLUDED
 #define PLAYER_INCLUDED
 
+#include <cstddef>
+#include <new>
 #include <string>
+#include <string_view>
 
 class Point;
 class Board;
@@ -10,17 +13,21 @@ class Game;
 class Player
 {
 public:
-    Player(std::string nm, const Game& g)
+    Player(std::string_view nm, const Game& g)
     : m_name(nm), m_game(g)
     {}
     
     virtual ~Player() {}
     
-    std::string name() const { return m_name; }
+    std::string_view name() const { return m_name; }
     const Game& game() const { return m_game; }
     
     virtual bool isHuman() const { return false; }
+    // The type createPlayer knows this player by
+    virtual const char* typeName() const = 0;
     
+    // Return to the state of a freshly created player, keeping the storage
+    virtual void reset() = 0;
     virtual bool placeShips(Board& b) = 0;
     virtual Point recommendAttack() = 0;
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
@@ -35,6 +42,77 @@ private:
     const Game& m_game;
 };
 
-Player* createPlayer(std::string type, std::string nm, const Game& g);
+// How to build one player type: on the heap, or in place in storage of
+// size bytes aligned to align.  Both return nullptr if the type can't play
+// the game's board -- montecarlo only plays boards of up to MASKCELLS cells,
+// density boards of up to 250000.
+struct PlayerFactory
+{
+    std::size_t size;
+    std::size_t align;
+    Player* (*create)(std::string_view nm, const Game& g);
+    Player* (*createAt)(void* storage, std::string_view nm, const Game& g);
+};
+
+// The factory of a Player subclass constructible from a name and a game
+template <class P>
+PlayerFactory playerFactory()
+{
+    PlayerFactory f;
+    f.size = sizeof(P);
+    f.align = alignof(P);
+    f.create = [](std::string_view nm, const Game& g) -> Player* { return new P(nm, g); };
+    f.createAt = [](void* storage, std::string_view nm, const Game& g) -> Player* { return new (storage) P(nm, g); };
+    return f;
+}
+
+// A registered player type.  Look it up by name once with findPlayerType;
+// after that, creating players of it involves no string work at all.
+class PlayerType
+{
+public:
+    PlayerType() : m_entry(nullptr) {}
+    bool isValid() const { return m_entry != nullptr; }
+    std::string_view name() const;
+    std::size_t size() const;
+    std::size_t align() const;
+    Player* create(std::string_view nm, const Game& g) const;
+    Player* createAt(void* storage, std::string_view nm, const Game& g) const;
+    
+    struct Entry;
+    
+private:
+    friend PlayerType registerPlayerType(std::string_view type, const PlayerFactory& f);
+    friend PlayerType findPlayerType(std::string_view type);
+    explicit PlayerType(const Entry* e) : m_entry(e) {}
+    
+    const Entry* m_entry;
+};
+
+PlayerType registerPlayerType(std::string_view type, const PlayerFactory& f);
+PlayerType findPlayerType(std::string_view type);
+
+// Storage that players are created in and destroyed in place.  It only
+// allocates when a player bigger than any before it is created in it, so
+// a slot can hold player after player without touching the heap.
+class PlayerSlot
+{
+public:
+    PlayerSlot() : m_storage(nullptr), m_size(0), m_align(0), m_player(nullptr) {}
+    ~PlayerSlot();
+    Player* create(PlayerType type, std::string_view nm, const Game& g);
+    void destroy();
+    Player* get() const { return m_player; }
+    // We prevent a PlayerSlot object from being copied or assigned
+    PlayerSlot(const PlayerSlot&) = delete;
+    PlayerSlot& operator=(const PlayerSlot&) = delete;
+    
+private:
+    void* m_storage;
+    std::size_t m_size, m_align;
+    Player* m_player;
+};
+
+Player* createPlayer(std::string_view type, std::string_view nm, const Game& g);
 
 #endif // PLAYER_INCLUDED
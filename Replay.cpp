@@ -0,0 +1,156 @@
+#include "Replay.h"
+#include "Board.h"
+#include "Game.h"
+#include "Player.h"
+#include <string>
+
+using namespace std;
+
+/**
+    Replay constructor
+
+    @param1 rec The record to replay -- it must outlive the replay
+    Sets the game up to its first turn -- use isValid to learn whether that worked
+ */
+Replay::Replay(const GameRecordView& rec)
+: m_rec(rec), m_turn(0), m_valid(false)
+{
+    restart();
+}
+
+Replay::~Replay()
+{
+}
+
+/**
+    Rebuilds the game and places the ships, leaving it at its first turn
+
+    Everything is recreated from the seed, so earlier random choices leave no trace
+ */
+void Replay::restart()
+{
+    // Drop the old players and boards before the game they refer to
+    for (int i = 0; i < 2; i++)
+    {
+        m_boards[i].reset();
+        m_players[i].reset();
+    }
+    m_game.reset(new Game(m_rec.rows(), m_rec.cols()));
+    m_turn = 0;
+    m_valid = false;
+
+    // Same order as Tournament: seed, fleet, then the players in creation order
+    m_game->seed(m_rec.seed());
+    for (int id = 0; id < m_rec.nShips(); id++)
+        if (!m_game->addShip(m_rec.shipLength(id), m_rec.shipSymbol(id), string(m_rec.shipName(id))))
+            return;
+    for (int i = 0; i < 2; i++)
+    {
+        string type(m_rec.playerType(i));
+        if (type == "human")
+            return;
+        m_players[i].reset(createPlayer(type, i == 0 ? "Player 1" : "Player 2", *m_game));
+        if (m_players[i] == nullptr)
+            return;
+        m_boards[i].reset(new Board(*m_game));
+    }
+
+    // As in Game::play the first mover places its ships first
+    int first = m_rec.firstMover();
+    if (!m_players[first]->placeShips(*m_boards[first]) ||
+        !m_players[1 - first]->placeShips(*m_boards[1 - first]))
+        return;
+    m_valid = true;
+}
+
+/**
+    Returns where a recorded shot went
+
+    @param1 k Index of the shot
+    @return The cell shot at -- (0, 0) for an invalid shot off the board
+ */
+Point Replay::recordedShot(long k) const
+{
+    int cell = m_rec.shot(k).cell;
+    return Point(cell / m_rec.cols(), cell % m_rec.cols());
+}
+
+/**
+    Applies one shot to the defender's board and tells the attacker the result
+
+    @param1 k Index of the shot -- the turn being played
+    @param2 p Where the attacker shot
+    @param3 fire False for a recorded invalid shot, whose cell may not have been kept
+    @return True if the board answered as the record says
+ */
+bool Replay::applyShot(long k, Point p, bool fire)
+{
+    RecordedShot s = m_rec.shot(k);
+    int a = attacker();
+    bool shotHit = false, shipDestroyed = false, validShot = false;
+    int shipId = 100;
+    if (fire)
+        validShot = m_boards[1 - a]->attack(p, shotHit, shipDestroyed, shipId);
+    m_players[a]->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+    m_turn++;
+
+    ShotResult result = (!validShot ? SHOT_INVALID :
+                         (shipDestroyed ? SHOT_SUNK : (shotHit ? SHOT_HIT : SHOT_MISS)));
+    return result == s.result && (result != SHOT_SUNK || shipId == s.shipId);
+}
+
+/**
+    Jumps to a turn by applying the recorded shots directly
+
+    @param1 k Turn to stop at -- the first k shots will have been fired
+    The players are told every result, but never asked for a move, so their own random
+    choices fall out of step with the record; use rerun to reproduce those exactly
+    @return False if the game is invalid, or a board or the board size disagreed with the record
+ */
+bool Replay::fastForward(long k)
+{
+    if (k < m_turn)
+        restart();
+    if (!m_valid)
+        return false;
+    if (k > nTurns())
+        k = nTurns();
+    while (m_turn < k)
+    {
+        // Shots off the board are recorded at cell 0, so a cell past the end means a
+        // corrupt record -- and the players only expect cells of their board
+        RecordedShot s = m_rec.shot(m_turn);
+        if (s.cell >= m_rec.rows() * m_rec.cols())
+            return false;
+        if (!applyShot(m_turn, recordedShot(m_turn), s.result != SHOT_INVALID))
+            return false;
+    }
+    return true;
+}
+
+/**
+    Replays turns by asking the players for their moves, as Game::play would
+
+    @param1 k Turn to stop at
+    Always starts over from the first turn, so every random choice is made as it was
+    @return The first turn whose move or result differs from the record, or the turn
+            reached if they all agreed -- -1 if the game is invalid
+ */
+long Replay::rerun(long k)
+{
+    restart();
+    if (!m_valid)
+        return -1;
+    if (k > nTurns())
+        k = nTurns();
+    while (m_turn < k)
+    {
+        long t = m_turn;
+        RecordedShot s = m_rec.shot(t);
+        Point p = m_players[attacker()]->recommendAttack();
+        bool sameCell = (s.result == SHOT_INVALID || p.r * m_rec.cols() + p.c == s.cell);
+        if (!applyShot(t, p, true) || !sameCell)
+            return t;
+    }
+    return m_turn;
+}
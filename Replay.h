@@ -0,0 +1,49 @@
+#ifndef REPLAY_INCLUDED
+#define REPLAY_INCLUDED
+
+#include "GameRecord.h"
+#include "globals.h"
+#include <memory>
+
+class Board;
+class Game;
+class Player;
+
+// Rebuilds a recorded game from its seed and shots.  The game is set up as
+// Tournament sets it up -- same seed, fleet, and player creation order, and
+// the first mover places its ships first -- so every random choice of the
+// boards and players comes out as it did.  Games with a human player can't
+// be rebuilt, since their ships were placed by hand.
+class Replay
+{
+public:
+    Replay(const GameRecordView& rec);
+    ~Replay();
+    bool isValid() const { return m_valid; }
+    long turn() const { return m_turn; }
+    long nTurns() const { return m_rec.nShots(); }
+    int attacker() const { return m_rec.firstMover() ^ static_cast<int>(m_turn & 1); }
+    const Game& game() const { return *m_game; }
+    const Board& board(int player) const { return *m_boards[player]; }
+    Player& player(int player) const { return *m_players[player]; }
+    Point recordedShot(long k) const;
+
+    bool fastForward(long k);
+    long rerun(long k);
+    void restart();
+    // We prevent a Replay object from being copied or assigned
+    Replay(const Replay&) = delete;
+    Replay& operator=(const Replay&) = delete;
+
+private:
+    bool applyShot(long k, Point p, bool fire);
+
+    GameRecordView m_rec;
+    std::unique_ptr<Game> m_game;
+    std::unique_ptr<Player> m_players[2];
+    std::unique_ptr<Board> m_boards[2];
+    long m_turn;
+    bool m_valid;
+};
+
+#endif // REPLAY_INCLUDED
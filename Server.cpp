@@ -0,0 +1,702 @@
+#include "Server.h"
+#include "Game.h"
+#include "GameObserver.h"
+#include "Player.h"
+#include "globals.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+    // epoll tags above any session index mark the listeners and the wake-up descriptor
+    const uint64_t LISTENERTAG = uint64_t(1) << 32;
+    const uint64_t WAKETAG = uint64_t(2) << 32;
+    // A client line longer than this is not one the protocol has
+    const size_t MAXLINE = 256;
+    // Bytes read from one client per wakeup; epoll reports the rest on the next pass,
+    // so a client that keeps sending can't hold the loop while the others wait
+    const size_t MAXREAD = 16 * 4096;
+    // Output waiting for a client that doesn't read it; past this the server
+    // stops reading from that client until the output has gone out
+    const size_t MAXPENDING = 64 * 1024;
+    // How long the listeners rest when the process is out of descriptors
+    const int ACCEPTPAUSEMS = 100;
+    const int MAXEVENTS = 256;
+
+    void appendNumber(string& out, long n)
+    {
+        char digits[24];
+        int len = 0;
+        unsigned long u = (n < 0 ? 0 - static_cast<unsigned long>(n) : static_cast<unsigned long>(n));
+        do
+        {
+            digits[len++] = static_cast<char>('0' + u % 10);
+            u /= 10;
+        } while (u > 0);
+        if (n < 0)
+            out += '-';
+        while (len > 0)
+            out += digits[--len];
+    }
+
+    // Stands for a client in its session's game.  Its moves come from the
+    // socket, so it is never asked for one; its ships are placed by a
+    // computer player of the server's placer type.
+    class ClientPlayer : public Player
+    {
+    public:
+        ClientPlayer(string_view nm, const Game& g, Player& placer) : Player(nm, g), m_placer(placer) {}
+
+        virtual bool isHuman() const { return true; }
+        virtual const char* typeName() const { return "client"; }
+
+        virtual void reset() { m_placer.reset(); }
+        virtual bool placeShips(Board& b) { return m_placer.placeShips(b); }
+        virtual Point recommendAttack() { return Point(); }
+        virtual void recordAttackResult(Point, bool, bool, bool, int) { /* the client is told by the protocol writer */ }
+        virtual void recordAttackByOpponent(Point) { /* do nothing */ }
+
+    private:
+        Player& m_placer;
+    };
+
+    // Turns the events of a session's game into protocol lines
+    class ProtocolWriter : public GameObserver
+    {
+    public:
+        ProtocolWriter(string& out) : m_out(out), m_client(nullptr) {}
+        void setClient(const Player* client) { m_client = client; }
+
+        virtual void attackMade(const Player& attacker, Point p, bool validShot,
+                                bool shotHit, bool shipDestroyed, int shipId,
+                                const Board& /* b */, bool /* shotsOnly */)
+        {
+            m_out += (&attacker == m_client ? "SHOT " : "ENEMY ");
+            appendNumber(m_out, p.r);
+            m_out += ' ';
+            appendNumber(m_out, p.c);
+            if (!validShot)
+                m_out += " INVALID\n";
+            else if (shipDestroyed)
+            {
+                m_out += " SUNK ";
+                m_out += attacker.game().shipName(shipId);
+                m_out += '\n';
+            }
+            else
+                m_out += (shotHit ? " HIT\n" : " MISS\n");
+        }
+        virtual void gameWon(const Player& winner)
+        {
+            m_out += (&winner == m_client ? "WIN\n" : "LOSE\n");
+        }
+
+    private:
+        string& m_out;
+        const Player* m_client;
+    };
+}
+
+class GameServerImpl
+{
+public:
+    // Constructor
+    GameServerImpl(const ServerOptions& options);
+    // Destructor
+    ~GameServerImpl();
+
+    // Accessors
+    long gamesFinished() const { return m_gamesFinished.load(memory_order_relaxed); }
+    int nSessions() const { return m_nSessions.load(memory_order_relaxed); }
+
+    // Other
+    bool listenTcp(int port);
+    bool listenUnix(const string& path);
+    bool run();
+    void stop();
+
+private:
+    // One client's connection and the game it is playing.  The game is a
+    // GameRun whose client side is external, so between the client's moves
+    // it is simply parked.  Everything but the descriptor and the buffers
+    // outlives the connection, so the next client to get the session
+    // reuses its game and players.
+    struct Session
+    {
+        int index;
+        int fd = -1;
+        string in, out;
+        ProtocolWriter protocol{out};
+        // What the session is waiting for in the epoll set
+        uint32_t events = EPOLLIN;
+        bool closing = false;
+        long game = 0;
+        unique_ptr<Game> g;
+        unique_ptr<GameRun> run;
+        PlayerSlot opponentSlot, placerSlot;
+        Player* opponent = nullptr;
+        Player* placer = nullptr;
+        unique_ptr<ClientPlayer> client;
+    };
+    bool addListener(int fd);
+    void acceptClients(int listener);
+    void pauseAccepting(bool pause);
+    bool buildSession(Session& s);
+    void readFrom(Session& s);
+    void writeTo(Session& s);
+    void handleLine(Session& s, char* line);
+    void startGame(Session& s);
+    void continueGame(Session& s, GameRun::State state);
+    void close(int index);
+
+    ServerOptions m_options;
+    PlayerType m_opponent, m_placer;
+    int m_epoll, m_wake;
+    vector<int> m_listeners;
+    bool m_acceptPaused;
+    vector<string> m_unixPaths;
+    // Sessions are never freed -- a closed one waits on the free list for the next client
+    vector<unique_ptr<Session> > m_sessions;
+    vector<int> m_free;
+    long m_gamesStarted;
+    atomic<long> m_gamesFinished;
+    atomic<int> m_nSessions;
+};
+
+/**
+    GameServerImpl constructor
+
+    @param1 options The shape of every game and the player types to use
+    The types are looked up once, here; run fails if either is unknown
+ */
+GameServerImpl::GameServerImpl(const ServerOptions& options)
+: m_options(options), m_opponent(findPlayerType(options.opponent)),
+  m_placer(findPlayerType(options.placer)), m_acceptPaused(false), m_gamesStarted(0),
+  m_gamesFinished(0), m_nSessions(0)
+{
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll >= 0 && m_wake >= 0)
+    {
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = WAKETAG;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &ev);
+    }
+}
+
+/**
+    GameServerImpl destructor
+    Drops every client and removes the Unix socket files it created
+ */
+GameServerImpl::~GameServerImpl()
+{
+    for (const unique_ptr<Session>& s : m_sessions)
+        if (s->fd >= 0)
+            ::close(s->fd);
+    for (int fd : m_listeners)
+        ::close(fd);
+    for (const string& path : m_unixPaths)
+        unlink(path.c_str());
+    if (m_wake >= 0)
+        ::close(m_wake);
+    if (m_epoll >= 0)
+        ::close(m_epoll);
+}
+
+/**
+    Listens for clients on a TCP port of the loopback interface
+
+    @param1 port The port
+    @return True if the port could be bound
+ */
+bool GameServerImpl::listenTcp(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    return addListener(fd);
+}
+
+/**
+    Listens for clients on a Unix domain socket
+
+    @param1 path Where the socket file goes -- an old file there is replaced
+    @return True if the socket could be bound
+ */
+bool GameServerImpl::listenUnix(const string& path)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    if (path.size() >= sizeof(addr.sun_path))
+        return false;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_unixPaths.push_back(path);
+    return addListener(fd);
+}
+
+/**
+    Starts listening on a bound socket and adds it to the epoll set
+
+    @param1 fd The socket -- closed if it can't be used
+ */
+bool GameServerImpl::addListener(int fd)
+{
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTENERTAG | m_listeners.size();
+    if (m_epoll < 0 || listen(fd, SOMAXCONN) < 0 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_listeners.push_back(fd);
+    return true;
+}
+
+/**
+    Serves clients until stop is called
+
+    @return False if the server could not start -- no listener, or an unknown player type
+ */
+bool GameServerImpl::run()
+{
+    if (m_epoll < 0 || m_wake < 0 || m_listeners.empty() || m_options.addShips == nullptr ||
+        !m_opponent.isValid() || !m_placer.isValid())
+        return false;
+    epoll_event events[MAXEVENTS];
+    for (;;)
+    {
+        int n = epoll_wait(m_epoll, events, MAXEVENTS, m_acceptPaused ? ACCEPTPAUSEMS : -1);
+        if (n < 0 && errno != EINTR)
+            return false;
+        // Descriptors may have been freed elsewhere in the meantime
+        if (n == 0 && m_acceptPaused)
+            pauseAccepting(false);
+        for (int i = 0; i < n; i++)
+        {
+            uint64_t tag = events[i].data.u64;
+            if (tag == WAKETAG)
+            {
+                uint64_t count;
+                if (read(m_wake, &count, sizeof(count)) < 0) {}
+                return true;
+            }
+            if (tag & LISTENERTAG)
+            {
+                acceptClients(m_listeners[tag & ~LISTENERTAG]);
+                continue;
+            }
+            // A session closed earlier in this batch has nothing left to do
+            Session& s = *m_sessions[tag];
+            if (s.fd < 0)
+                continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+                s.closing = true;
+            else
+            {
+                if (events[i].events & EPOLLIN)
+                    readFrom(s);
+                if (s.fd >= 0 && !s.out.empty())
+                    writeTo(s);
+            }
+            if (s.fd >= 0 && s.closing && s.out.empty())
+                close(s.index);
+        }
+    }
+}
+
+/**
+    Makes run return -- safe to call from any thread
+ */
+void GameServerImpl::stop()
+{
+    uint64_t one = 1;
+    if (write(m_wake, &one, sizeof(one)) < 0) {}
+}
+
+/**
+    Accepts every pending client on a listener and starts a game for each
+
+    @param1 listener The listening socket
+    Out of descriptors, the listeners are paused -- a pending client keeps them readable,
+    so they would otherwise wake the loop again and again
+ */
+void GameServerImpl::acceptClients(int listener)
+{
+    for (;;)
+    {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EMFILE || errno == ENFILE)
+                pauseAccepting(true);
+            return;
+        }
+        // Moves are tiny, so they go out at once rather than waiting to be merged -- this
+        // fails harmlessly on a Unix socket
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        int index;
+        if (!m_free.empty())
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            index = static_cast<int>(m_sessions.size());
+            m_sessions.emplace_back(new Session);
+            m_sessions.back()->index = index;
+        }
+        Session& s = *m_sessions[index];
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = static_cast<uint64_t>(index);
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) < 0)
+        {
+            ::close(fd);
+            m_free.push_back(index);
+            continue;
+        }
+        s.fd = fd;
+        s.in.clear();
+        s.out.clear();
+        s.events = EPOLLIN;
+        s.closing = false;
+        m_nSessions.fetch_add(1, memory_order_relaxed);
+        if (s.g == nullptr && !buildSession(s))
+        {
+            s.out += "ERROR the game could not be set up\n";
+            s.closing = true;
+        }
+        else
+            startGame(s);
+        writeTo(s);
+        if (s.fd >= 0 && s.closing && s.out.empty())
+            close(index);
+    }
+}
+
+/**
+    Stops or resumes waiting for clients on every listener
+
+    @param1 pause True to stop -- pending clients wait in the listen backlog
+    A pause ends when a session closes, or after ACCEPTPAUSEMS without any event
+ */
+void GameServerImpl::pauseAccepting(bool pause)
+{
+    if (pause == m_acceptPaused)
+        return;
+    for (size_t i = 0; i < m_listeners.size(); i++)
+    {
+        epoll_event ev;
+        ev.events = 0;
+        if (!pause)
+            ev.events = EPOLLIN;
+        ev.data.u64 = LISTENERTAG | i;
+        epoll_ctl(m_epoll, EPOLL_CTL_MOD, m_listeners[i], &ev);
+    }
+    m_acceptPaused = pause;
+}
+
+/**
+    Builds the game and players of a session the first time it is used
+
+    @param1 s The session
+    @return False if the fleet could not be added, or a player type can't play the board
+ */
+bool GameServerImpl::buildSession(Session& s)
+{
+    unique_ptr<Game> g(new Game(m_options.rows, m_options.cols));
+    if (!m_options.addShips(*g) || g->nShips() == 0)
+        return false;
+    s.opponent = s.opponentSlot.create(m_opponent, "Computer", *g);
+    s.placer = s.placerSlot.create(m_placer, "Placer", *g);
+    // The session is only kept once it is complete, so a later client tries again
+    if (s.opponent == nullptr || s.placer == nullptr)
+    {
+        s.opponentSlot.destroy();
+        s.placerSlot.destroy();
+        s.opponent = s.placer = nullptr;
+        return false;
+    }
+    s.g = move(g);
+    s.client.reset(new ClientPlayer("Client", *s.g, *s.placer));
+    s.run.reset(new GameRun(*s.g));
+    s.protocol.setClient(s.client.get());
+    return true;
+}
+
+/**
+    Reads whatever the client has sent and handles each complete line
+
+    @param1 s The session
+    Stops after MAXREAD bytes or once MAXPENDING bytes of output wait, and closes the
+    session once the unfinished line is too long
+ */
+void GameServerImpl::readFrom(Session& s)
+{
+    char chunk[4096];
+    size_t total = 0;
+    while (!s.closing && total < MAXREAD && s.out.size() < MAXPENDING)
+    {
+        ssize_t n = recv(s.fd, chunk, sizeof(chunk), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        {
+            // The client is gone -- whatever it was still owed can't be delivered
+            s.out.clear();
+            s.closing = true;
+            return;
+        }
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        total += n;
+        s.in.append(chunk, n);
+
+        // Lines are cut in place, and the handled ones erased at once
+        size_t start = 0;
+        for (size_t nl; !s.closing && (nl = s.in.find('\n', start)) != string::npos; start = nl + 1)
+        {
+            s.in[nl] = '\0';
+            handleLine(s, &s.in[start]);
+        }
+        s.in.erase(0, start);
+        if (s.in.size() > MAXLINE)
+        {
+            s.out += "ERROR line too long\n";
+            s.closing = true;
+        }
+    }
+}
+
+/**
+    Sends as much of the session's output as the socket takes
+
+    @param1 s The session
+    Asks epoll for writability only while output is left over, and for input only while
+    less than MAXPENDING bytes of it are left
+ */
+void GameServerImpl::writeTo(Session& s)
+{
+    size_t sent = 0;
+    while (sent < s.out.size())
+    {
+        ssize_t n = send(s.fd, s.out.data() + sent, s.out.size() - sent, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                s.out.clear();
+                s.closing = true;
+                return;
+            }
+            break;
+        }
+        sent += n;
+    }
+    s.out.erase(0, sent);
+    uint32_t events = 0;
+    if (s.out.size() < MAXPENDING)
+        events |= EPOLLIN;
+    if (!s.out.empty())
+        events |= EPOLLOUT;
+    if (events != s.events)
+    {
+        epoll_event ev;
+        ev.events = events;
+        ev.data.u64 = static_cast<uint64_t>(s.index);
+        epoll_ctl(m_epoll, EPOLL_CTL_MOD, s.fd, &ev);
+        s.events = events;
+    }
+}
+
+/**
+    Acts on one line from the client
+
+    @param1 s The session
+    @param2 line The line, without its newline
+ */
+void GameServerImpl::handleLine(Session& s, char* line)
+{
+    size_t len = strlen(line);
+    if (len > 0 && line[len - 1] == '\r')
+        line[--len] = '\0';
+    if (strcmp(line, "QUIT") == 0)
+    {
+        s.closing = true;
+        return;
+    }
+    if (s.run->state() != GameRun::AWAITING_MOVE)
+    {
+        if (strcmp(line, "NEW") == 0)
+            startGame(s);
+        else
+            s.out += "ERROR the game is over -- send NEW or QUIT\n";
+        return;
+    }
+
+    // Anything else must be a move
+    char* end;
+    long r = strtol(line, &end, 10);
+    char* rowEnd = end;
+    long c = strtol(rowEnd, &end, 10);
+    Point p(static_cast<int>(r), static_cast<int>(c));
+    if (rowEnd == line || end == rowEnd || *end != '\0' || r != p.r || c != p.c)
+    {
+        s.out += "ERROR expected a row and a column\nTURN\n";
+        return;
+    }
+    // The client's shot, then the computer's reply -- the protocol writer reports both
+    continueGame(s, s.run->move(p));
+}
+
+/**
+    Starts the session's next game -- the computer moves first in even numbered games
+
+    @param1 s The session
+ */
+void GameServerImpl::startGame(Session& s)
+{
+    s.game = ++m_gamesStarted;
+    s.g->seed(Rng::mix(m_options.seed + s.game));
+    s.opponent->reset();
+    s.client->reset();
+    Player* client = s.client.get();
+    bool clientFirst = (s.game % 2 == 1);
+    if (!s.run->start(clientFirst ? client : s.opponent, clientFirst ? s.opponent : client,
+                      &s.protocol))
+    {
+        s.out += "ERROR the ships could not be placed\n";
+        s.closing = true;
+        return;
+    }
+    s.run->setExternal(0, clientFirst);
+    s.run->setExternal(1, !clientFirst);
+    s.out += "GAME ";
+    appendNumber(s.out, s.game);
+    s.out += ' ';
+    appendNumber(s.out, s.g->rows());
+    s.out += ' ';
+    appendNumber(s.out, s.g->cols());
+    s.out += '\n';
+    continueGame(s, GameRun::READY);
+}
+
+/**
+    Plays the computer's turns until the client has to move or the game is over
+
+    @param1 s The session
+    @param2 state The state the run was left in
+ */
+void GameServerImpl::continueGame(Session& s, GameRun::State state)
+{
+    if (state == GameRun::READY)
+        state = s.run->resume();
+    if (state == GameRun::AWAITING_MOVE)
+        s.out += "TURN\n";
+    else if (state == GameRun::OVER)
+        m_gamesFinished.fetch_add(1, memory_order_relaxed);
+}
+
+/**
+    Drops a client and puts its session on the free list
+
+    @param1 index The session's index
+ */
+void GameServerImpl::close(int index)
+{
+    Session& s = *m_sessions[index];
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, s.fd, nullptr);
+    ::close(s.fd);
+    s.fd = -1;
+    m_free.push_back(index);
+    m_nSessions.fetch_sub(1, memory_order_relaxed);
+    // The descriptor just freed can take a waiting client
+    pauseAccepting(false);
+}
+
+//******************** GameServer functions ***************************
+
+GameServer::GameServer(const ServerOptions& options)
+{
+    m_impl = new GameServerImpl(options);
+}
+
+GameServer::~GameServer()
+{
+    delete m_impl;
+}
+
+bool GameServer::listenTcp(int port)
+{
+    return m_impl->listenTcp(port);
+}
+
+bool GameServer::listenUnix(const string& path)
+{
+    return m_impl->listenUnix(path);
+}
+
+bool GameServer::run()
+{
+    return m_impl->run();
+}
+
+void GameServer::stop()
+{
+    m_impl->stop();
+}
+
+long GameServer::gamesFinished() const
+{
+    return m_impl->gamesFinished();
+}
+
+int GameServer::nSessions() const
+{
+    return m_impl->nSessions();
+}
@@ -0,0 +1,62 @@
+#ifndef SERVER_INCLUDED
+#define SERVER_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+class Game;
+class GameServerImpl;
+
+// What every game of a server looks like
+struct ServerOptions
+{
+    int rows = 10;
+    int cols = 10;
+    // Adds the fleet to each freshly built game
+    bool (*addShips)(Game&) = nullptr;
+    // Player type of the computer the clients play against
+    std::string opponent = "good";
+    // Player type that places the clients' ships for them
+    std::string placer = "good";
+    // Game k is seeded from this and k alone, as in a tournament
+    std::uint64_t seed = 0;
+};
+
+// Serves games against a computer player to clients on local sockets,
+// all from one thread.  An epoll loop waits on every connection at once;
+// a game waiting for its client's move is a GameRun stopped at the
+// client's turn, so it costs memory but no thread.  Sessions are kept
+// after their clients leave and reused, game, players and boards included.
+//
+// The protocol is line based.  The server sends
+//
+//    GAME <number> <rows> <cols>       a game has started, ships placed
+//    TURN                              the server waits for a move
+//    SHOT <r> <c> <result>             the result of the client's shot
+//    ENEMY <r> <c> <result>            the computer's shot and its result
+//    WIN  or  LOSE                     the game is over
+//    ERROR <message>
+//
+// where a result is MISS, HIT, SUNK <ship name>, or INVALID.  The client
+// sends "<r> <c>" after each TURN, NEW after a game is over to play again,
+// and QUIT to leave.  Clients move first in odd numbered games.
+class GameServer
+{
+public:
+    GameServer(const ServerOptions& options);
+    ~GameServer();
+    bool listenTcp(int port);
+    bool listenUnix(const std::string& path);
+    bool run();
+    void stop();
+    long gamesFinished() const;
+    int nSessions() const;
+    // We prevent a GameServer object from being copied or assigned
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+private:
+    GameServerImpl* m_impl;
+};
+
+#endif // SERVER_INCLUDED
@@ -0,0 +1,224 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+using namespace std;
+
+class ThreadPoolImpl
+{
+public:
+    // Constructor
+    ThreadPoolImpl(int nThreads);
+    // Destructor
+    ~ThreadPoolImpl();
+    
+    // Accessor
+    int size() const { return m_nWorkers; }
+    
+    // Other
+    void parallelFor(long n, long grain, const function<void(int, long, long)>& task);
+    
+private:
+    // A worker's remaining slice of the current job -- padded to its own cache line
+    struct alignas(64) Slice
+    {
+        mutex m_lock;
+        long m_begin = 0;
+        long m_end = 0;
+    };
+    void workerLoop(int worker);
+    void runJob(int worker);
+    bool takeOwn(int worker, long& begin, long& end);
+    bool steal(int thief);
+    
+    int m_nWorkers;
+    vector<Slice> m_slices;
+    vector<thread> m_threads;
+    // Job hand-off between the calling thread and the workers
+    mutex m_jobLock;
+    condition_variable m_jobReady;
+    condition_variable m_jobDone;
+    const function<void(int, long, long)>* m_task;
+    long m_grain;
+    unsigned long m_generation;
+    int m_busy;
+    bool m_stopping;
+};
+
+/**
+    ThreadPoolImpl constructor
+ 
+    @param1 nThreads Number of workers -- 0 or less means one per hardware thread
+    The calling thread of parallelFor acts as worker 0, so only nThreads-1 threads are started
+ */
+ThreadPoolImpl::ThreadPoolImpl(int nThreads)
+: m_task(nullptr), m_grain(1), m_generation(0), m_busy(0), m_stopping(false)
+{
+    if (nThreads <= 0)
+        nThreads = max(1u, thread::hardware_concurrency());
+    m_nWorkers = nThreads;
+    m_slices = vector<Slice>(m_nWorkers);
+    for (int w = 1; w < m_nWorkers; w++)
+        m_threads.push_back(thread(&ThreadPoolImpl::workerLoop, this, w));
+}
+
+/**
+    Destructor
+ 
+    Wakes every worker and waits for it to exit
+ */
+ThreadPoolImpl::~ThreadPoolImpl()
+{
+    {
+        lock_guard<mutex> lk(m_jobLock);
+        m_stopping = true;
+    }
+    m_jobReady.notify_all();
+    for (auto& t : m_threads)
+        t.join();
+}
+
+/**
+    Runs task over every index in [0, n) and returns once all of it is done
+ 
+    @param1 n Number of indices
+    @param2 grain Number of consecutive indices handed to task at a time
+    @param3 task Called as task(worker, begin, end) -- worker is in [0, size())
+ */
+void ThreadPoolImpl::parallelFor(long n, long grain, const function<void(int, long, long)>& task)
+{
+    if (n <= 0)
+        return;
+    // Give each worker an equal contiguous slice to start with
+    for (int w = 0; w < m_nWorkers; w++)
+    {
+        m_slices[w].m_begin = n * w / m_nWorkers;
+        m_slices[w].m_end = n * (w + 1) / m_nWorkers;
+    }
+    {
+        lock_guard<mutex> lk(m_jobLock);
+        m_task = &task;
+        m_grain = max(1L, grain);
+        m_busy = m_nWorkers;
+        m_generation++;
+    }
+    m_jobReady.notify_all();
+    // The caller works too, then waits for the stragglers
+    runJob(0);
+    unique_lock<mutex> lk(m_jobLock);
+    m_jobDone.wait(lk, [this]{ return m_busy == 0; });
+    m_task = nullptr;
+}
+
+/**
+    Body of each started thread -- sleeps until a job is posted, runs it, repeats
+ 
+    @param1 worker Index of this worker
+ */
+void ThreadPoolImpl::workerLoop(int worker)
+{
+    unsigned long seen = 0;
+    for (;;)
+    {
+        {
+            unique_lock<mutex> lk(m_jobLock);
+            m_jobReady.wait(lk, [&]{ return m_stopping || m_generation != seen; });
+            if (m_stopping)
+                return;
+            seen = m_generation;
+        }
+        runJob(worker);
+    }
+}
+
+/**
+    Drains the worker's own slice, then steals until no work is left anywhere
+ 
+    @param1 worker Index of this worker
+ */
+void ThreadPoolImpl::runJob(int worker)
+{
+    long begin, end;
+    for (;;)
+    {
+        if (takeOwn(worker, begin, end))
+            (*m_task)(worker, begin, end);
+        else if (!steal(worker))
+            break;
+    }
+    lock_guard<mutex> lk(m_jobLock);
+    if (--m_busy == 0)
+        m_jobDone.notify_one();
+}
+
+/**
+    Takes the next grain of indices from the front of the worker's own slice
+ 
+    @return True if any indices were taken
+ */
+bool ThreadPoolImpl::takeOwn(int worker, long& begin, long& end)
+{
+    Slice& s = m_slices[worker];
+    lock_guard<mutex> lk(s.m_lock);
+    if (s.m_begin >= s.m_end)
+        return false;
+    begin = s.m_begin;
+    end = min(s.m_end, begin + m_grain);
+    s.m_begin = end;
+    return true;
+}
+
+/**
+    Moves the back half of some other worker's slice into the thief's slice
+ 
+    @param1 thief Index of the worker that ran out of work
+    @return True if anything was stolen
+ */
+bool ThreadPoolImpl::steal(int thief)
+{
+    for (int k = 1; k < m_nWorkers; k++)
+    {
+        Slice& victim = m_slices[(thief + k) % m_nWorkers];
+        long begin, end;
+        {
+            lock_guard<mutex> lk(victim.m_lock);
+            long left = victim.m_end - victim.m_begin;
+            if (left <= 0)
+                continue;
+            // Leave the victim the front half -- it is working from the front
+            begin = victim.m_begin + left / 2;
+            end = victim.m_end;
+            victim.m_end = begin;
+        }
+        Slice& own = m_slices[thief];
+        lock_guard<mutex> lk(own.m_lock);
+        own.m_begin = begin;
+        own.m_end = end;
+        return true;
+    }
+    return false;
+}
+
+//******************** ThreadPool functions ***************************
+
+ThreadPool::ThreadPool(int nThreads)
+{
+    m_impl = new ThreadPoolImpl(nThreads);
+}
+
+ThreadPool::~ThreadPool()
+{
+    delete m_impl;
+}
+
+int ThreadPool::size() const
+{
+    return m_impl->size();
+}
+
+void ThreadPool::parallelFor(long n, long grain,
+                             const function<void(int worker, long begin, long end)>& task)
+{
+    m_impl->parallelFor(n, grain, task);
+}
@@ -0,0 +1,29 @@
+#ifndef THREADPOOL_INCLUDED
+#define THREADPOOL_INCLUDED
+
+#include <functional>
+#include <thread>
+#include <vector>
+
+class ThreadPoolImpl;
+
+// A fixed set of worker threads that split index ranges between them.
+// Every worker starts with an equal slice of the range and, once its own
+// slice runs dry, steals half of whatever a busier worker has left.
+class ThreadPool
+{
+public:
+    ThreadPool(int nThreads = 0);
+    ~ThreadPool();
+    int size() const;
+    void parallelFor(long n, long grain,
+                     const std::function<void(int worker, long begin, long end)>& task);
+    // We prevent a ThreadPool object from being copied or assigned
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+private:
+    ThreadPoolImpl* m_impl;
+};
+
+#endif // THREADPOOL_INCLUDED
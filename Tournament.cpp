@@ -0,0 +1,136 @@
+#include "Tournament.h"
+#include "Game.h"
+#include "GameRecord.h"
+#include "Player.h"
+#include "ThreadPool.h"
+#include "TurnLog.h"
+#include "globals.h"
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/**
+    Tournament constructor
+ 
+    @param1 nRows Number of rows of every board
+    @param2 nCols Number of columns of every board
+    @param3 addShips Adds the fleet to each freshly built game
+    @param4 type1 Player type of the first player -- as accepted by createPlayer
+    @param5 type2 Player type of the second player
+    The master seed is random until seed() is called
+ */
+Tournament::Tournament(int nRows, int nCols, bool (*addShips)(Game&), string type1, string type2)
+: m_rows(nRows), m_cols(nCols), m_addShips(addShips), m_type1(type1), m_type2(type2),
+  m_seed(threadRng().next())
+{}
+
+/**
+    Plays the games and tallies the results
+ 
+    @param1 nGames Number of games to play -- the first player starts the odd numbered games
+    @param2 nThreads Number of threads to use -- 0 means one per hardware thread
+    Game k is seeded from the master seed and k alone, so results do not depend on scheduling
+    Every game goes to the record writer, if one was given, in whatever order the games finish
+    Likewise every turn goes to the log, if one was given, which is flushed before returning
+    @return The merged win counts of all workers
+ */
+TournamentResult Tournament::run(long nGames, int nThreads) const
+{
+    // Each worker tallies into its own cache line so nothing is shared until the merge
+    struct alignas(64) Tally
+    {
+        long wins1 = 0, wins2 = 0, noResult = 0;
+    };
+    // The types are looked up once, here, rather than by every worker
+    PlayerType type1 = findPlayerType(m_type1);
+    PlayerType type2 = findPlayerType(m_type2);
+    
+    // Each worker builds one game and its players once, and resets them for every game it plays
+    struct Session
+    {
+        Session(const Tournament& t, PlayerType type1, PlayerType type2)
+        : g(t.m_rows, t.m_cols)
+        {
+            t.m_addShips(g);
+            p1 = slot1.create(type1, "Player 1", g);
+            p2 = slot2.create(type2, "Player 2", g);
+            if (t.m_record != nullptr)
+                recorder.reset(new GameRecorder(*t.m_record));
+            if (t.m_log != nullptr)
+                logger.reset(new TurnLogger(*t.m_log, g));
+            // Games report to whichever of the two is there, or to both
+            if (recorder && logger)
+                tee.reset(new TeeObserver(*recorder, *logger));
+            observer = (tee ? tee.get() : recorder ? recorder.get() :
+                        static_cast<GameObserver*>(logger.get()));
+        }
+        Game g;
+        PlayerSlot slot1, slot2;
+        Player* p1;
+        Player* p2;
+        unique_ptr<GameRecorder> recorder;
+        unique_ptr<TurnLogger> logger;
+        unique_ptr<TeeObserver> tee;
+        GameObserver* observer;
+    };
+    ThreadPool pool(nThreads);
+    vector<Tally> tallies(pool.size());
+    vector<unique_ptr<Session> > sessions(pool.size());
+    
+    auto start = chrono::steady_clock::now();
+    pool.parallelFor(nGames, 64, [&](int worker, long begin, long end)
+    {
+        Tally& t = tallies[worker];
+        if (sessions[worker] == nullptr)
+            sessions[worker].reset(new Session(*this, type1, type2));
+        Session& s = *sessions[worker];
+        Player* p1 = s.p1;
+        Player* p2 = s.p2;
+        // An unknown type gives games without a result, as createPlayer's nullptr would
+        if (p1 == nullptr || p2 == nullptr)
+        {
+            t.noResult += end - begin;
+            return;
+        }
+        for (long k = begin + 1; k <= end; k++)
+        {
+            uint64_t seed = Rng::mix(m_seed + k);
+            s.g.seed(seed);
+            p1->reset();
+            p2->reset();
+            if (s.recorder)
+                s.recorder->beginGame(s.g, seed, *p1, m_type1, *p2, m_type2);
+            if (s.logger)
+                s.logger->beginGame(k);
+            Player* winner = (k % 2 == 1 ?
+                              s.g.play(p1, p2, s.observer) : s.g.play(p2, p1, s.observer));
+            if (s.recorder)
+                s.recorder->endGame();
+            if (winner == p1)
+                t.wins1++;
+            else if (winner == p2)
+                t.wins2++;
+            else
+                t.noResult++;
+        }
+    });
+    if (m_record != nullptr)
+        m_record->flush();
+    if (m_log != nullptr)
+        m_log->flush();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    
+    // Merge the per-worker tallies
+    TournamentResult result;
+    result.games = nGames;
+    for (const Tally& t : tallies)
+    {
+        result.wins1 += t.wins1;
+        result.wins2 += t.wins2;
+        result.noResult += t.noResult;
+    }
+    result.seconds = elapsed.count();
+    return result;
+}
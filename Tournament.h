@@ -0,0 +1,41 @@
+#ifndef TOURNAMENT_INCLUDED
+#define TOURNAMENT_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+class Game;
+class GameRecordWriter;
+class TurnLog;
+
+struct TournamentResult
+{
+    long games = 0;
+    long wins1 = 0;
+    long wins2 = 0;
+    long noResult = 0;
+    double seconds = 0;
+};
+
+// Plays many independent games between two player types across all cores.
+// Like main's match, the players take turns going first.
+class Tournament
+{
+public:
+    Tournament(int nRows, int nCols, bool (*addShips)(Game&),
+               std::string type1, std::string type2);
+    void seed(std::uint64_t s) { m_seed = s; }
+    void record(GameRecordWriter* out) { m_record = out; }
+    void log(TurnLog* out) { m_log = out; }
+    TournamentResult run(long nGames, int nThreads = 0) const;
+    
+private:
+    int m_rows, m_cols;
+    bool (*m_addShips)(Game&);
+    std::string m_type1, m_type2;
+    std::uint64_t m_seed;
+    GameRecordWriter* m_record = nullptr;
+    TurnLog* m_log = nullptr;
+};
+
+#endif // TOURNAMENT_INCLUDED
@@ -0,0 +1,362 @@
+#include "TurnLog.h"
+#include "Game.h"
+#include "Player.h"
+#include <chrono>
+#include <ostream>
+
+using namespace std;
+
+namespace
+{
+    const size_t FLUSHBYTES = 1 << 16;
+    // Events formatted per hold of the names lock
+    const size_t BATCH = 4096;
+    // How long an idle writer sleeps before it looks at the queue again
+    const chrono::microseconds IDLESLEEP(1000);
+
+    void appendNumber(string& out, int64_t n)
+    {
+        char digits[24];
+        int len = 0;
+        uint64_t u = (n < 0 ? 0 - static_cast<uint64_t>(n) : static_cast<uint64_t>(n));
+        do
+        {
+            digits[len++] = static_cast<char>('0' + u % 10);
+            u /= 10;
+        } while (u > 0);
+        if (n < 0)
+            out += '-';
+        while (len > 0)
+            out += digits[--len];
+    }
+}
+
+//*********************************************************************
+//  TurnLog
+//*********************************************************************
+
+/**
+    TurnLog constructor
+
+    @param1 out Where the formatted events go -- e.g. cout or an ofstream that outlives the log
+    @param2 overflow What push does when the queue is full
+    @param3 capacity Number of events the queue holds -- rounded up to a power of two
+    @param4 sampleEvery Under LOG_SAMPLE, how many events share one place once the queue is half full
+    Starts the writer thread
+ */
+TurnLog::TurnLog(ostream& out, LogOverflow overflow, size_t capacity, int sampleEvery)
+: m_out(out), m_overflow(overflow), m_sampleEvery(sampleEvery < 1 ? 1 : sampleEvery),
+  m_tail(0), m_head(0), m_written(0), m_dropped(0), m_stopping(false), m_droppedReported(0)
+{
+    size_t n = 2;
+    while (n < capacity)
+        n *= 2;
+    m_cells.reset(new Cell[n]);
+    m_mask = n - 1;
+    // Slot i is free for the producer that claims position i
+    for (size_t i = 0; i < n; i++)
+        m_cells[i].seq.store(i, memory_order_relaxed);
+    m_buffer.reserve(FLUSHBYTES + FLUSHBYTES / 4);
+    m_writer = thread(&TurnLog::writerLoop, this);
+}
+
+/**
+    Writes every event pushed so far, then stops the writer
+ */
+TurnLog::~TurnLog()
+{
+    m_stopping.store(true, memory_order_release);
+    m_writer.join();
+}
+
+/**
+    Returns the id that stands for a name in events
+
+    @param1 name A player or ship name
+    Takes a lock, so call it once per name and keep the id
+    @return The id, or NONAME once there are too many names
+ */
+uint16_t TurnLog::intern(string_view name)
+{
+    lock_guard<mutex> guard(m_namesLock);
+    for (size_t i = 0; i < m_names.size(); i++)
+        if (m_names[i] == name)
+            return static_cast<uint16_t>(i);
+    if (m_names.size() == NONAME)
+        return NONAME;
+    m_names.emplace_back(name);
+    return static_cast<uint16_t>(m_names.size() - 1);
+}
+
+/**
+    Hands an event to the writer
+
+    @param1 e The event
+    Never takes a lock; only LOG_BLOCK ever waits, and only while the queue is full
+    @return False if the event was dropped
+ */
+bool TurnLog::push(const TurnEvent& e)
+{
+    if (m_overflow == LOG_SAMPLE)
+    {
+        // The head is read first, so the difference can't come out negative
+        size_t head = m_head.load(memory_order_relaxed);
+        size_t used = m_tail.load(memory_order_relaxed) - head;
+        thread_local unsigned long nSampled = 0;
+        if (used > m_mask / 2 && ++nSampled % m_sampleEvery != 0)
+        {
+            m_dropped.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+    }
+    if (tryPush(e))
+        return true;
+    if (m_overflow == LOG_BLOCK)
+    {
+        m_wake.notify_one();
+        while (!tryPush(e))
+            this_thread::yield();
+        return true;
+    }
+    m_dropped.fetch_add(1, memory_order_relaxed);
+    return false;
+}
+
+/**
+    Waits until every event pushed before the call has been written to the stream
+ */
+void TurnLog::flush()
+{
+    size_t target = m_tail.load(memory_order_acquire);
+    while (m_written.load(memory_order_acquire) < target)
+        this_thread::sleep_for(IDLESLEEP / 4);
+}
+
+/**
+    Claims the next free slot and fills it
+
+    @param1 e The event
+    @return False if the queue is full
+ */
+bool TurnLog::tryPush(const TurnEvent& e)
+{
+    size_t pos = m_tail.load(memory_order_relaxed);
+    Cell* cell;
+    for (;;)
+    {
+        cell = &m_cells[pos & m_mask];
+        size_t seq = cell->seq.load(memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        // The slot is free for this position -- try to claim it
+        if (diff == 0)
+        {
+            if (m_tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                break;
+        }
+        // The writer has not emptied the slot from the previous lap
+        else if (diff < 0)
+            return false;
+        // Another producer claimed it first
+        else
+            pos = m_tail.load(memory_order_relaxed);
+    }
+    cell->event = e;
+    cell->seq.store(pos + 1, memory_order_release);
+    return true;
+}
+
+/**
+    Takes the oldest event, if its producer has finished filling it
+
+    @param1 e Set to the event
+    Only called by the writer thread
+    @return False if there is none
+ */
+bool TurnLog::tryPop(TurnEvent& e)
+{
+    size_t pos = m_head.load(memory_order_relaxed);
+    Cell& cell = m_cells[pos & m_mask];
+    if (cell.seq.load(memory_order_acquire) != pos + 1)
+        return false;
+    e = cell.event;
+    // Free the slot for the producer one lap ahead
+    cell.seq.store(pos + m_mask + 1, memory_order_release);
+    m_head.store(pos + 1, memory_order_relaxed);
+    return true;
+}
+
+/**
+    Appends one line describing an event to the buffer
+
+    @param1 e The event
+    Called with the names lock held
+ */
+void TurnLog::format(const TurnEvent& e)
+{
+    static const string unknown = "?";
+    const string& player = (e.player < m_names.size() ? m_names[e.player] : unknown);
+    m_buffer += "game ";
+    appendNumber(m_buffer, static_cast<int64_t>(e.game));
+    if (e.kind == TurnEvent::WON)
+    {
+        m_buffer += ": ";
+        m_buffer += player;
+        m_buffer += " wins\n";
+        return;
+    }
+    m_buffer += " turn ";
+    appendNumber(m_buffer, e.turn);
+    m_buffer += ": ";
+    m_buffer += player;
+    m_buffer += (e.result == SHOT_INVALID ? " wasted a shot at (" : " attacked (");
+    appendNumber(m_buffer, e.r);
+    m_buffer += ',';
+    appendNumber(m_buffer, e.c);
+    m_buffer += ')';
+    if (e.result == SHOT_SUNK)
+    {
+        m_buffer += " and destroyed the ";
+        m_buffer += (e.ship < m_names.size() ? m_names[e.ship] : unknown);
+    }
+    else if (e.result == SHOT_HIT)
+        m_buffer += " and hit something";
+    else if (e.result == SHOT_MISS)
+        m_buffer += " and missed";
+    m_buffer += '\n';
+}
+
+/**
+    Body of the writer thread
+
+    Drains the queue in batches and writes once the buffer is large or the queue is empty,
+    so a busy log makes few large writes.  An idle writer naps briefly and looks again;
+    producers only wake it when the queue is full and they would have to wait.
+ */
+void TurnLog::writerLoop()
+{
+    for (;;)
+    {
+        // Read before draining, so every event pushed before the stop is written
+        bool stopping = m_stopping.load(memory_order_acquire);
+        size_t n = 0;
+        {
+            lock_guard<mutex> guard(m_namesLock);
+            TurnEvent e;
+            while (n < BATCH && tryPop(e))
+            {
+                format(e);
+                n++;
+            }
+        }
+        uint64_t dropped = m_dropped.load(memory_order_relaxed);
+        if (dropped != m_droppedReported)
+        {
+            m_buffer += "(";
+            appendNumber(m_buffer, static_cast<int64_t>(dropped - m_droppedReported));
+            m_buffer += " events dropped)\n";
+            m_droppedReported = dropped;
+        }
+        bool drained = (n < BATCH);
+        if (!m_buffer.empty() && (drained || m_buffer.size() >= FLUSHBYTES))
+        {
+            m_out.write(m_buffer.data(), m_buffer.size());
+            m_out.flush();
+            m_buffer.clear();
+        }
+        // Everything taken so far has reached the stream
+        if (drained)
+            m_written.store(m_head.load(memory_order_relaxed), memory_order_release);
+        if (n == 0)
+        {
+            if (stopping)
+                return;
+            unique_lock<mutex> guard(m_wakeLock);
+            m_wake.wait_for(guard, IDLESLEEP);
+        }
+    }
+}
+
+//*********************************************************************
+//  TurnLogger
+//*********************************************************************
+
+/**
+    TurnLogger constructor
+
+    @param1 log Where the events go
+    @param2 g The game to be observed, with its fleet already added -- its ship names are interned now
+ */
+TurnLogger::TurnLogger(TurnLog& log, const Game& g)
+: m_log(log), m_shipIds(g.nShips()), m_game(0), m_turn(0)
+{
+    for (int id = 0; id < g.nShips(); id++)
+        m_shipIds[id] = log.intern(g.shipName(id));
+    m_playerIds[0] = m_playerIds[1] = TurnLog::NONAME;
+}
+
+/**
+    Starts numbering the turns of a game
+
+    @param1 game The number the game's events carry
+ */
+void TurnLogger::beginGame(uint64_t game)
+{
+    m_game = game;
+    m_turn = 0;
+}
+
+/**
+    Returns the id of a player's name
+
+    @param1 p The player
+    Only a name that is not one of the last two seen needs the log's lock
+ */
+uint16_t TurnLogger::playerId(const Player& p)
+{
+    string_view name = p.name();
+    for (int i = 0; i < 2; i++)
+        if (m_playerIds[i] != TurnLog::NONAME && m_playerNames[i] == name)
+            return m_playerIds[i];
+    m_playerNames[1] = m_playerNames[0];
+    m_playerIds[1] = m_playerIds[0];
+    m_playerNames[0] = name;
+    m_playerIds[0] = m_log.intern(name);
+    return m_playerIds[0];
+}
+
+void TurnLogger::attackMade(const Player& attacker, Point p, bool validShot,
+                            bool shotHit, bool shipDestroyed, int shipId,
+                            const Board& /* b */, bool /* shotsOnly */)
+{
+    TurnEvent e;
+    e.game = m_game;
+    e.turn = m_turn++;
+    e.player = playerId(attacker);
+    e.ship = TurnLog::NONAME;
+    e.r = static_cast<int16_t>(p.r);
+    e.c = static_cast<int16_t>(p.c);
+    e.kind = TurnEvent::SHOT;
+    if (!validShot)
+        e.result = SHOT_INVALID;
+    else if (shotHit && shipDestroyed)
+    {
+        e.result = SHOT_SUNK;
+        e.ship = m_shipIds[shipId];
+    }
+    else
+        e.result = (shotHit ? SHOT_HIT : SHOT_MISS);
+    m_log.push(e);
+}
+
+void TurnLogger::gameWon(const Player& winner)
+{
+    TurnEvent e;
+    e.game = m_game;
+    e.turn = m_turn;
+    e.player = playerId(winner);
+    e.ship = TurnLog::NONAME;
+    e.r = e.c = 0;
+    e.kind = TurnEvent::WON;
+    e.result = 0;
+    m_log.push(e);
+}
@@ -0,0 +1,121 @@
+#ifndef TURNLOG_INCLUDED
+#define TURNLOG_INCLUDED
+
+#include "GameObserver.h"
+#include "GameRecord.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class Game;
+
+// What a producer does when the log's queue is full
+enum LogOverflow {
+    LOG_DROP,       // the event is dropped and counted
+    LOG_BLOCK,      // the producer waits until the writer makes room
+    LOG_SAMPLE      // past half full only one event in every sampleEvery is kept
+};
+
+// One turn of a game, as small as it can be.  Names are not copied into
+// events -- the log interns them once and events carry their ids.
+struct TurnEvent
+{
+    enum Kind : std::uint8_t { SHOT, WON };
+    std::uint64_t game;
+    std::uint32_t turn;
+    std::uint16_t player;
+    std::uint16_t ship;
+    std::int16_t r, c;
+    Kind kind;
+    std::uint8_t result;
+};
+
+// Writes turn events to a stream from a thread of its own, so the threads
+// playing games never wait on output.  Producers put events in a bounded
+// lock-free queue; the writer drains it, formats the events into a buffer,
+// and writes the buffer in large blocks.  Any number of threads may push.
+class TurnLog
+{
+public:
+    static const std::uint16_t NONAME = 0xffff;
+
+    TurnLog(std::ostream& out, LogOverflow overflow = LOG_DROP,
+            std::size_t capacity = 1 << 16, int sampleEvery = 16);
+    ~TurnLog();
+    std::uint16_t intern(std::string_view name);
+    bool push(const TurnEvent& e);
+    void flush();
+    std::uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    // We prevent a TurnLog object from being copied or assigned
+    TurnLog(const TurnLog&) = delete;
+    TurnLog& operator=(const TurnLog&) = delete;
+
+private:
+    // A queue slot -- seq tells producers and the writer whose turn it is
+    struct Cell
+    {
+        std::atomic<std::size_t> seq;
+        TurnEvent event;
+    };
+    bool tryPush(const TurnEvent& e);
+    bool tryPop(TurnEvent& e);
+    void format(const TurnEvent& e);
+    void writerLoop();
+
+    std::ostream& m_out;
+    LogOverflow m_overflow;
+    int m_sampleEvery;
+    std::unique_ptr<Cell[]> m_cells;
+    std::size_t m_mask;
+    // Producers share the tail, only the writer moves the head
+    alignas(64) std::atomic<std::size_t> m_tail;
+    alignas(64) std::atomic<std::size_t> m_head;
+    // Queue position up to which every event has reached the stream
+    std::atomic<std::size_t> m_written;
+    std::atomic<std::uint64_t> m_dropped;
+    std::atomic<bool> m_stopping;
+    // An idle writer naps on this -- only a producer held up by a full queue wakes it early
+    std::mutex m_wakeLock;
+    std::condition_variable m_wake;
+    // Interned names -- the writer holds the lock while it formats a batch
+    std::mutex m_namesLock;
+    std::vector<std::string> m_names;
+    std::string m_buffer;
+    std::uint64_t m_droppedReported;
+    std::thread m_writer;
+};
+
+// Turns the callbacks of Game::play into turn events for a log.  Call
+// beginGame before each game.  The logger is meant to be reused, and only
+// interns a name again when it meets a player name it has not cached.
+class TurnLogger : public GameObserver
+{
+public:
+    TurnLogger(TurnLog& log, const Game& g);
+    void beginGame(std::uint64_t game);
+
+    virtual void attackMade(const Player& attacker, Point p, bool validShot,
+                            bool shotHit, bool shipDestroyed, int shipId,
+                            const Board& b, bool shotsOnly);
+    virtual void gameWon(const Player& winner);
+
+private:
+    std::uint16_t playerId(const Player& p);
+
+    TurnLog& m_log;
+    std::vector<std::uint16_t> m_shipIds;
+    // The last two player names seen, and their ids
+    std::string m_playerNames[2];
+    std::uint16_t m_playerIds[2];
+    std::uint64_t m_game;
+    std::uint32_t m_turn;
+};
+
+#endif // TURNLOG_INCLUDED
@@ -0,0 +1,566 @@
+// Micro and macro benchmarks of the engine: the Board operations, each
+// player's placeShips and moves, and whole games for every pairing of the
+// computer players -- built from scratch (play.*) and on a reused game and
+// players (reuse.*).  Build from the repository root with e.g.
+//   g++ -std=c++17 -O2 -I. bench/bench.cpp Board.cpp Game.cpp GameObserver.cpp Instrument.cpp
+//       Heatmap.cpp PlacementTable.cpp Player.cpp ThreadPool.cpp -pthread -o bench
+//
+// Every benchmark is run --reps times for at least --min-time seconds each,
+// and reports the median and the median absolute deviation of those runs,
+// along with heap allocations per operation.  --out writes the results as
+// tab-separated lines, one per benchmark, which a later run can be compared
+// against with --baseline; the exit status is 1 if anything got slower by
+// more than --threshold percent and more than three deviations.
+//
+//   bench [--reps N] [--min-time S] [--filter TEXT] [--out FILE]
+//         [--baseline FILE] [--threshold PCT]
+
+#include "Board.h"
+#include "Fleet.h"
+#include "Game.h"
+#include "Player.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//*********************************************************************
+//  Allocation counting
+//*********************************************************************
+
+// Every heap allocation of the program goes through these.  The whole set
+// of plain, array, sized and nothrow forms is replaced, so whichever form
+// the compiler picks, memory from malloc goes back to free.  The free sits
+// out of line, where inlining can't pair it with the operator new call.
+static atomic<long> g_allocs(0);
+
+static void* countedAlloc(size_t n) noexcept
+{
+    g_allocs.fetch_add(1, memory_order_relaxed);
+    return malloc(n == 0 ? 1 : n);
+}
+
+__attribute__((noinline)) static void countedFree(void* p) noexcept
+{
+    free(p);
+}
+
+void* operator new(size_t n)
+{
+    if (void* p = countedAlloc(n))
+        return p;
+    throw bad_alloc();
+}
+
+void* operator new[](size_t n)
+{
+    if (void* p = countedAlloc(n))
+        return p;
+    throw bad_alloc();
+}
+
+void* operator new(size_t n, const nothrow_t&) noexcept
+{
+    return countedAlloc(n);
+}
+
+void* operator new[](size_t n, const nothrow_t&) noexcept
+{
+    return countedAlloc(n);
+}
+
+void operator delete(void* p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept
+{
+    countedFree(p);
+}
+
+//*********************************************************************
+//  Sample
+//*********************************************************************
+
+// Accumulates the time, allocations and operations of the timed sections
+// of one run of a benchmark
+class Sample
+{
+public:
+    void start()
+    {
+        m_allocsAtStart = g_allocs.load(memory_order_relaxed);
+        m_startTime = chrono::steady_clock::now();
+    }
+    void stop(long nOps)
+    {
+        m_elapsed += chrono::steady_clock::now() - m_startTime;
+        m_allocs += g_allocs.load(memory_order_relaxed) - m_allocsAtStart;
+        m_ops += nOps;
+    }
+    double seconds() const { return m_elapsed.count(); }
+    long allocs() const { return m_allocs; }
+    long ops() const { return m_ops; }
+
+private:
+    chrono::steady_clock::time_point m_startTime;
+    chrono::duration<double> m_elapsed = chrono::duration<double>(0);
+    long m_allocsAtStart = 0;
+    long m_allocs = 0;
+    long m_ops = 0;
+};
+
+// A benchmark runs one batch of work per call, timing it with the Sample
+struct Benchmark
+{
+    string name;
+    function<void(Sample&)> batch;
+};
+
+struct Result
+{
+    string name;
+    double nsPerOp;
+    double mad;
+    double allocsPerOp;
+};
+
+//*********************************************************************
+//  Workloads
+//*********************************************************************
+
+namespace
+{
+    const char* const AITYPES[] = { "awful", "mediocre", "good", "density", "montecarlo" };
+    const int NBOARDS = 256;
+
+    // Where each ship of a layout goes
+    struct Layout
+    {
+        vector<Point> at;
+        vector<Direction> dir;
+    };
+
+    // Random legal layouts of g's fleet, found by trial as the awful player does
+    vector<Layout> makeLayouts(const Game& g, int n)
+    {
+        vector<Layout> layouts(n);
+        Board b(g);
+        for (Layout& l : layouts)
+        {
+            b.clear();
+            for (int id = 0; id < g.nShips(); id++)
+            {
+                Point p;
+                Direction d;
+                do
+                {
+                    p = g.randomPoint();
+                    d = (g.rng().randInt(2) == 0 ? HORIZONTAL : VERTICAL);
+                } while (!b.placeShip(p, id, d));
+                l.at.push_back(p);
+                l.dir.push_back(d);
+            }
+        }
+        return layouts;
+    }
+
+    void place(Board& b, const Layout& l)
+    {
+        for (int id = 0; id < static_cast<int>(l.at.size()); id++)
+            b.placeShip(l.at[id], id, l.dir[id]);
+    }
+
+    // State shared by the batches of the Board benchmarks
+    struct BoardFixture
+    {
+        BoardFixture() : g(10, 10)
+        {
+            addFleet<StandardFleet>(g);
+            g.seed(1);
+            layouts = makeLayouts(g, NBOARDS);
+            for (int i = 0; i < NBOARDS; i++)
+                boards.emplace_back(new Board(g));
+            for (int cell = 0; cell < g.rows() * g.cols(); cell++)
+                order.push_back(Point(cell / g.cols(), cell % g.cols()));
+            for (int i = static_cast<int>(order.size()) - 1; i > 0; i--)
+                swap(order[i], order[g.rng().randInt(i + 1)]);
+        }
+        Game g;
+        vector<Layout> layouts;
+        vector<unique_ptr<Board> > boards;
+        vector<Point> order;
+    };
+
+    void addBoardBenchmarks(vector<Benchmark>& benches)
+    {
+        shared_ptr<BoardFixture> f(new BoardFixture);
+        int nShips = f->g.nShips();
+        benches.push_back({ "board.placeShip", [f, nShips](Sample& s)
+        {
+            for (auto& b : f->boards)
+                b->clear();
+            s.start();
+            for (int i = 0; i < NBOARDS; i++)
+                place(*f->boards[i], f->layouts[i]);
+            s.stop(long(NBOARDS) * nShips);
+        }});
+        benches.push_back({ "board.unplaceShip", [f, nShips](Sample& s)
+        {
+            for (int i = 0; i < NBOARDS; i++)
+            {
+                f->boards[i]->clear();
+                place(*f->boards[i], f->layouts[i]);
+            }
+            s.start();
+            for (int i = 0; i < NBOARDS; i++)
+            {
+                const Layout& l = f->layouts[i];
+                for (int id = 0; id < nShips; id++)
+                    f->boards[i]->unplaceShip(l.at[id], id, l.dir[id]);
+            }
+            s.stop(long(NBOARDS) * nShips);
+        }});
+        benches.push_back({ "board.attack", [f](Sample& s)
+        {
+            for (int i = 0; i < NBOARDS; i++)
+            {
+                f->boards[i]->clear();
+                place(*f->boards[i], f->layouts[i]);
+            }
+            bool hit, destroyed;
+            int shipId;
+            s.start();
+            for (auto& b : f->boards)
+                for (Point p : f->order)
+                    b->attack(p, hit, destroyed, shipId);
+            s.stop(long(NBOARDS) * f->order.size());
+        }});
+    }
+
+    void addPlayerBenchmarks(vector<Benchmark>& benches, const string& type)
+    {
+        // placeShips reuses one player and board; clearing the board is not timed
+        struct PlaceFixture
+        {
+            PlaceFixture(const string& type) : g(10, 10)
+            {
+                addFleet<StandardFleet>(g);
+                g.seed(2);
+                p.reset(createPlayer(type, "Bench", g));
+                b.reset(new Board(g));
+            }
+            Game g;
+            unique_ptr<Player> p;
+            unique_ptr<Board> b;
+        };
+        shared_ptr<PlaceFixture> pf(new PlaceFixture(type));
+        benches.push_back({ type + ".placeShips", [pf](Sample& s)
+        {
+            for (int k = 0; k < 16; k++)
+            {
+                pf->b->clear();
+                s.start();
+                pf->p->placeShips(*pf->b);
+                s.stop(1);
+            }
+        }});
+
+        // One move is recommendAttack, the shot at the board, and recordAttackResult;
+        // each batch is a fresh player shooting a fresh layout until it is sunk
+        shared_ptr<long> nGames(new long(0));
+        benches.push_back({ type + ".move", [type, nGames](Sample& s)
+        {
+            Game g(10, 10);
+            addFleet<StandardFleet>(g);
+            g.seed(Rng::mix(++*nGames));
+            Board b(g);
+            place(b, makeLayouts(g, 1)[0]);
+            unique_ptr<Player> p(createPlayer(type, "Bench", g));
+            long moves = 0;
+            bool hit, destroyed;
+            int shipId;
+            s.start();
+            while (!b.allShipsDestroyed())
+            {
+                Point at = p->recommendAttack();
+                bool valid = b.attack(at, hit, destroyed, shipId);
+                p->recordAttackResult(at, valid, hit, destroyed, shipId);
+                moves++;
+            }
+            s.stop(moves);
+        }});
+    }
+
+    // A whole game, from building it to deleting the players, as main's match plays it
+    void addGameBenchmark(vector<Benchmark>& benches, const string& type1, const string& type2)
+    {
+        shared_ptr<long> nGames(new long(0));
+        benches.push_back({ "play." + type1 + "-" + type2, [type1, type2, nGames](Sample& s)
+        {
+            long k = ++*nGames;
+            s.start();
+            Game g(10, 10);
+            g.seed(Rng::mix(k));
+            addFleet<StandardFleet>(g);
+            Player* p1 = createPlayer(type1, "Player 1", g);
+            Player* p2 = createPlayer(type2, "Player 2", g);
+            if (k % 2 == 1)
+                g.play(p1, p2, nullptr);
+            else
+                g.play(p2, p1, nullptr);
+            delete p1;
+            delete p2;
+            s.stop(1);
+        }});
+    }
+
+    // A whole game on a game and players kept from the last one, as Tournament plays it
+    void addReusedGameBenchmark(vector<Benchmark>& benches, const string& type1, const string& type2)
+    {
+        struct Session
+        {
+            Session(const string& type1, const string& type2) : g(10, 10), nGames(0)
+            {
+                addFleet<StandardFleet>(g);
+                p1.reset(createPlayer(type1, "Player 1", g));
+                p2.reset(createPlayer(type2, "Player 2", g));
+            }
+            Game g;
+            unique_ptr<Player> p1, p2;
+            long nGames;
+        };
+        shared_ptr<Session> session(new Session(type1, type2));
+        benches.push_back({ "reuse." + type1 + "-" + type2, [session](Sample& s)
+        {
+            Session& ss = *session;
+            long k = ++ss.nGames;
+            s.start();
+            ss.g.seed(Rng::mix(k));
+            ss.p1->reset();
+            ss.p2->reset();
+            if (k % 2 == 1)
+                ss.g.play(ss.p1.get(), ss.p2.get(), nullptr);
+            else
+                ss.g.play(ss.p2.get(), ss.p1.get(), nullptr);
+            s.stop(1);
+        }});
+    }
+}
+
+//*********************************************************************
+//  Statistics and reporting
+//*********************************************************************
+
+/**
+    Returns the median of some values
+
+    @param1 v The values -- reordered
+    @return The middle value, or the mean of the two middle values
+ */
+static double median(vector<double>& v)
+{
+    sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 == 1 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+/**
+    Runs a benchmark repeatedly and summarizes the runs
+
+    @param1 b The benchmark
+    @param2 reps Number of runs
+    @param3 minTime Timed seconds each run lasts at least
+    @return The median ns/op of the runs, their median absolute deviation, and allocations/op
+ */
+static Result measure(const Benchmark& b, int reps, double minTime)
+{
+    // One untimed batch warms the caches and any lazily built tables
+    Sample warmup;
+    b.batch(warmup);
+
+    vector<double> nsPerOp;
+    long allocs = 0, ops = 0;
+    for (int r = 0; r < reps; r++)
+    {
+        Sample s;
+        while (s.seconds() < minTime)
+            b.batch(s);
+        nsPerOp.push_back(s.seconds() * 1e9 / s.ops());
+        allocs += s.allocs();
+        ops += s.ops();
+    }
+    Result result;
+    result.name = b.name;
+    result.nsPerOp = median(nsPerOp);
+    vector<double> deviations;
+    for (double x : nsPerOp)
+        deviations.push_back(fabs(x - result.nsPerOp));
+    result.mad = median(deviations);
+    result.allocsPerOp = static_cast<double>(allocs) / ops;
+    return result;
+}
+
+/**
+    Reads results written by --out
+
+    @param1 path The file
+    @return The results by name -- empty if the file could not be read
+ */
+static map<string, Result> readResults(const string& path)
+{
+    map<string, Result> results;
+    ifstream in(path);
+    string line;
+    while (getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        istringstream fields(line);
+        Result r;
+        if (fields >> r.name >> r.nsPerOp >> r.mad >> r.allocsPerOp)
+            results[r.name] = r;
+    }
+    return results;
+}
+
+int main(int argc, char* argv[])
+{
+    int reps = 7;
+    double minTime = 0.05;
+    double threshold = 5;
+    string filter, outPath, baselinePath;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            cerr << "Missing value for " << arg << endl;
+            return 2;
+        }
+        if (arg == "--reps")
+            reps = max(atoi(argv[++i]), 1);
+        else if (arg == "--min-time")
+            minTime = atof(argv[++i]);
+        else if (arg == "--threshold")
+            threshold = atof(argv[++i]);
+        else if (arg == "--filter")
+            filter = argv[++i];
+        else if (arg == "--out")
+            outPath = argv[++i];
+        else if (arg == "--baseline")
+            baselinePath = argv[++i];
+        else
+        {
+            cerr << "Unknown option " << arg << endl;
+            return 2;
+        }
+    }
+
+    vector<Benchmark> benches;
+    addBoardBenchmarks(benches);
+    for (const char* type : AITYPES)
+        addPlayerBenchmarks(benches, type);
+    for (size_t i = 0; i < size(AITYPES); i++)
+        for (size_t j = i; j < size(AITYPES); j++)
+            addGameBenchmark(benches, AITYPES[i], AITYPES[j]);
+    for (size_t i = 0; i < size(AITYPES); i++)
+        for (size_t j = i; j < size(AITYPES); j++)
+            addReusedGameBenchmark(benches, AITYPES[i], AITYPES[j]);
+
+    map<string, Result> baseline;
+    if (!baselinePath.empty())
+    {
+        baseline = readResults(baselinePath);
+        if (baseline.empty())
+        {
+            cerr << "Cannot read baseline " << baselinePath << endl;
+            return 2;
+        }
+    }
+
+    cout << left << setw(28) << "benchmark" << right << setw(14) << "ns/op" << setw(10) << "mad"
+    << setw(12) << "ops/sec" << setw(12) << "allocs/op";
+    if (!baseline.empty())
+        cout << setw(10) << "change";
+    cout << endl;
+
+    vector<Result> results;
+    int nRegressions = 0;
+    for (const Benchmark& b : benches)
+    {
+        if (b.name.find(filter) == string::npos)
+            continue;
+        Result r = measure(b, reps, minTime);
+        results.push_back(r);
+        cout << left << setw(28) << r.name << right << fixed
+        << setprecision(1) << setw(14) << r.nsPerOp << setw(10) << r.mad
+        << setprecision(0) << setw(12) << 1e9 / r.nsPerOp
+        << setprecision(2) << setw(12) << r.allocsPerOp;
+
+        // A regression must clear both the threshold and the noise of either run
+        auto it = baseline.find(r.name);
+        if (it != baseline.end())
+        {
+            const Result& base = it->second;
+            double change = (r.nsPerOp - base.nsPerOp) / base.nsPerOp * 100;
+            bool regressed = change > threshold &&
+                             r.nsPerOp - base.nsPerOp > 3 * max(r.mad, base.mad);
+            cout << setprecision(1) << setw(9) << showpos << change << noshowpos << "%";
+            if (regressed)
+            {
+                cout << "  REGRESSED";
+                nRegressions++;
+            }
+        }
+        cout << endl;
+    }
+
+    if (!outPath.empty())
+    {
+        ofstream out(outPath);
+        out << "# benchmark\tns_per_op\tmad_ns\tallocs_per_op" << endl;
+        for (const Result& r : results)
+            out << r.name << '\t' << setprecision(6) << r.nsPerOp << '\t'
+            << r.mad << '\t' << r.allocsPerOp << endl;
+    }
+    if (nRegressions > 0)
+        cout << nRegressions << " benchmark(s) regressed against " << baselinePath << endl;
+    return nRegressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+// Compares incremental Heatmap updates against recomputing every placement
+// after each shot.  Build from the repository root with e.g.
+//   g++ -std=c++17 -O2 -I. bench/heatmap_bench.cpp Heatmap.cpp Board.cpp Game.cpp
+//       GameObserver.cpp PlacementTable.cpp -pthread -o heatmap_bench
+
+#include "Board.h"
+#include "Fleet.h"
+#include "Game.h"
+#include "Heatmap.h"
+#include "globals.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+    const int NGAMES = 2000;
+    Game g(10, 10);
+    addFleet<StandardFleet>(g);
+    g.seed(2024);
+    vector<int> lengths;
+    for (int id = 0; id < g.nShips(); id++)
+        lengths.push_back(g.shipLength(id));
+    
+    chrono::duration<double> incremental(0), full(0);
+    long moves = 0, mismatches = 0;
+    for (int n = 0; n < NGAMES; n++)
+    {
+        // A random fleet, shot at in a random order until it is sunk
+        Board b(g);
+        for (int id = 0; id < g.nShips(); id++)
+            while (!b.placeShip(g.randomPoint(), id, g.rng().randInt(2) == 0 ? HORIZONTAL : VERTICAL))
+                ;
+        vector<int> order(g.rows() * g.cols());
+        for (int i = 0; i < static_cast<int>(order.size()); i++)
+            order[i] = i;
+        for (int i = static_cast<int>(order.size()) - 1; i > 0; i--)
+            swap(order[i], order[g.rng().randInt(i + 1)]);
+        
+        Heatmap fast(g.rows(), g.cols(), lengths);
+        Heatmap slow(g.rows(), g.cols(), lengths);
+        for (int k = 0; k < static_cast<int>(order.size()) && !b.allShipsDestroyed(); k++)
+        {
+            bool hit = false, destroyed = false;
+            int shipId;
+            int cell = order[k];
+            b.attack(Point(cell / g.cols(), cell % g.cols()), hit, destroyed, shipId);
+            
+            auto t0 = chrono::steady_clock::now();
+            if (!hit)
+                fast.block(cell);
+            if (destroyed)
+                fast.shipSunk(g.shipLength(shipId));
+            auto t1 = chrono::steady_clock::now();
+            if (!hit)
+                slow.block(cell);
+            if (destroyed)
+                slow.shipSunk(g.shipLength(shipId));
+            slow.rebuild();
+            auto t2 = chrono::steady_clock::now();
+            incremental += t1 - t0;
+            full += t2 - t1;
+            moves++;
+            
+            for (int c = 0; c < fast.nCells(); c++)
+                if (fast.heat(c) != slow.heat(c))
+                    mismatches++;
+        }
+    }
+    double incNs = incremental.count() * 1e9 / moves;
+    double fullNs = full.count() * 1e9 / moves;
+    cout << moves << " moves over " << NGAMES << " games" << endl;
+    cout << "incremental update: " << incNs << " ns/move" << endl;
+    cout << "full recompute:     " << fullNs << " ns/move" << endl;
+    cout << "speedup:            " << fullNs / incNs << "x" << endl;
+    cout << "mismatched cells:   " << mismatches << endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+// Load generator for the game server (see Server.h).  Opens many clients
+// at once, plays every game with its own shuffled order of shots, and
+// reports games and moves per second along with the latency of a move --
+// from sending it to the server's next TURN, or to the end of the game.
+// Everything runs on one thread with one epoll loop, like the server.
+// Build from the repository root with e.g.
+//   g++ -std=c++17 -O2 -I. bench/loadgen.cpp -o loadgen
+//
+//   loadgen [--port N | --unix PATH] [--clients N] [--games N]
+
+#include "globals.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+    int64_t nowNs()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // One connection and the game it is playing
+    struct Client
+    {
+        int fd = -1;
+        string in;
+        long gamesLeft = 0;
+        // Cells in the order they will be shot at
+        vector<int> order;
+        size_t next = 0;
+        int cols = 1;
+        int64_t sentAt = 0;
+        Rng rng;
+    };
+
+    struct Totals
+    {
+        long games = 0;
+        long moves = 0;
+        long errors = 0;
+        vector<int64_t> latencies;
+    };
+
+    int connectTo(int port, const string& unixPath)
+    {
+        int fd;
+        int result;
+        if (!unixPath.empty())
+        {
+            sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, unixPath.c_str(), sizeof(addr.sun_path) - 1);
+            fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            result = (fd < 0 ? -1 : connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+        }
+        else
+        {
+            sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(static_cast<uint16_t>(port));
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            result = (fd < 0 ? -1 : connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+            int on = 1;
+            if (result == 0)
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+        if (result < 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Moves and commands are a few bytes, so a send that doesn't take them all means trouble
+    bool sendLine(Client& c, const char* text, size_t len)
+    {
+        return send(c.fd, text, len, MSG_NOSIGNAL) == static_cast<ssize_t>(len);
+    }
+
+    // Acts on one line from the server -- returns false once the client is done
+    bool handleLine(Client& c, const char* line, Totals& totals)
+    {
+        if (strncmp(line, "GAME ", 5) == 0)
+        {
+            long number, rows, cols;
+            if (sscanf(line + 5, "%ld %ld %ld", &number, &rows, &cols) != 3)
+                return false;
+            c.cols = static_cast<int>(cols);
+            c.order.resize(rows * cols);
+            for (size_t i = 0; i < c.order.size(); i++)
+                c.order[i] = static_cast<int>(i);
+            for (size_t i = c.order.size(); i > 1; i--)
+                swap(c.order[i - 1], c.order[c.rng.randInt(static_cast<int>(i))]);
+            c.next = 0;
+            return true;
+        }
+        bool over = (strcmp(line, "WIN") == 0 || strcmp(line, "LOSE") == 0);
+        if (strcmp(line, "TURN") != 0 && !over)
+        {
+            if (strncmp(line, "ERROR", 5) == 0)
+                totals.errors++;
+            return true;
+        }
+        if (c.sentAt != 0)
+        {
+            totals.latencies.push_back(nowNs() - c.sentAt);
+            c.sentAt = 0;
+        }
+        if (over)
+        {
+            totals.games++;
+            if (--c.gamesLeft <= 0)
+                return false;
+            return sendLine(c, "NEW\n", 4);
+        }
+        if (c.next == c.order.size())
+            return false;
+        int cell = c.order[c.next++];
+        char move[32];
+        int len = snprintf(move, sizeof(move), "%d %d\n", cell / c.cols, cell % c.cols);
+        c.sentAt = nowNs();
+        totals.moves++;
+        return sendLine(c, move, len);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int port = 7777;
+    string unixPath;
+    long nClients = 1000;
+    long nGames = 10;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            cerr << "Missing value for " << arg << endl;
+            return 2;
+        }
+        if (arg == "--port")
+            port = atoi(argv[++i]);
+        else if (arg == "--unix")
+            unixPath = argv[++i];
+        else if (arg == "--clients")
+            nClients = max(atol(argv[++i]), 1L);
+        else if (arg == "--games")
+            nGames = max(atol(argv[++i]), 1L);
+        else
+        {
+            cerr << "Unknown option " << arg << endl;
+            return 2;
+        }
+    }
+
+    // Thousands of clients need more descriptors than the usual soft limit
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    vector<Client> clients(nClients);
+    Totals totals;
+    totals.latencies.reserve(nClients * nGames * 60);
+    int64_t start = nowNs();
+    long active = 0;
+    for (long i = 0; i < nClients; i++)
+    {
+        Client& c = clients[i];
+        c.fd = connectTo(port, unixPath);
+        if (c.fd < 0)
+        {
+            cerr << "Could only connect " << i << " clients: " << strerror(errno) << endl;
+            break;
+        }
+        c.gamesLeft = nGames;
+        c.rng.reseed(static_cast<uint64_t>(i) + 1);
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = static_cast<uint64_t>(i);
+        epoll_ctl(epfd, EPOLL_CTL_ADD, c.fd, &ev);
+        active++;
+    }
+
+    epoll_event events[256];
+    char chunk[4096];
+    while (active > 0)
+    {
+        int n = epoll_wait(epfd, events, 256, 10000);
+        if (n == 0)
+        {
+            cerr << "The server stopped answering with " << active << " clients left" << endl;
+            break;
+        }
+        for (int e = 0; e < n; e++)
+        {
+            Client& c = clients[events[e].data.u64];
+            if (c.fd < 0)
+                continue;
+            ssize_t got = recv(c.fd, chunk, sizeof(chunk), 0);
+            bool alive = (got > 0);
+            if (alive)
+                c.in.append(chunk, got);
+            size_t begin = 0;
+            for (size_t nl; alive && (nl = c.in.find('\n', begin)) != string::npos; begin = nl + 1)
+            {
+                c.in[nl] = '\0';
+                alive = handleLine(c, &c.in[begin], totals);
+            }
+            c.in.erase(0, begin);
+            if (!alive)
+            {
+                close(c.fd);
+                c.fd = -1;
+                active--;
+            }
+        }
+    }
+    double seconds = (nowNs() - start) / 1e9;
+
+    vector<int64_t>& lat = totals.latencies;
+    sort(lat.begin(), lat.end());
+    auto micros = [&](double fraction)
+    {
+        if (lat.empty())
+            return 0.0;
+        size_t k = min(lat.size() - 1, static_cast<size_t>(fraction * lat.size()));
+        return lat[k] / 1000.0;
+    };
+    cout << fixed << setprecision(1);
+    cout << nClients << " clients played " << totals.games << " games, " << totals.moves
+    << " moves in " << setprecision(3) << seconds << " s" << endl;
+    cout << setprecision(0) << totals.games / seconds << " games/s, "
+    << totals.moves / seconds << " moves/s" << endl;
+    cout << setprecision(1) << "move latency us: p50 " << micros(0.50) << "  p99 " << micros(0.99)
+    << "  max " << (lat.empty() ? 0.0 : lat.back() / 1000.0) << endl;
+    if (totals.errors > 0)
+        cout << totals.errors << " errors" << endl;
+    return totals.errors > 0 || active > 0 ? 1 : 0;
+}
@@ -1,10 +1,11 @@
 #ifndef GLOBALS_INCLUDED
 #define GLOBALS_INCLUDED
 
+#include <cstdint>
 #include <random>
 
-const int MAXROWS = 10;
-const int MAXCOLS = 10;
+const int MAXROWS = 2000;
+const int MAXCOLS = 2000;
 
 enum Direction {
     HORIZONTAL, VERTICAL
@@ -19,13 +20,112 @@ public:
     int c;
 };
 
+// A small, fast, seedable random number generator (xoshiro256**).
+// Each game or thread owns its own, so no generator is ever shared.
+class Rng
+{
+public:
+    Rng(std::uint64_t seed = 0) { reseed(seed); }
+    
+    // Expand a 64-bit seed into the full state with splitmix64
+    void reseed(std::uint64_t seed)
+    {
+        for (int i = 0; i < 4; i++)
+            m_s[i] = mix(seed += 0x9e3779b97f4a7c15ULL);
+    }
+    
+    // Return 64 random bits
+    std::uint64_t next()
+    {
+        std::uint64_t result = rotl(m_s[1] * 5, 7) * 9;
+        std::uint64_t t = m_s[1] << 17;
+        m_s[2] ^= m_s[0];
+        m_s[3] ^= m_s[1];
+        m_s[1] ^= m_s[2];
+        m_s[0] ^= m_s[3];
+        m_s[2] ^= t;
+        m_s[3] = rotl(m_s[3], 45);
+        return result;
+    }
+    
+    // Return a uniformly distributed random int from 0 to limit-1
+    int randInt(int limit)
+    {
+        // Lemire's multiply-and-reject: no division in the common case
+        std::uint64_t range = static_cast<std::uint32_t>(limit);
+        std::uint64_t m = (next() >> 32) * range;
+        if (static_cast<std::uint32_t>(m) < range)
+        {
+            std::uint32_t threshold = static_cast<std::uint32_t>(-range) % range;
+            while (static_cast<std::uint32_t>(m) < threshold)
+                m = (next() >> 32) * range;
+        }
+        return static_cast<int>(m >> 32);
+    }
+    
+    // Fill words with random bits, e.g. a whole random mask at once
+    void fill(std::uint64_t* words, int nWords)
+    {
+        for (int i = 0; i < nWords; i++)
+            words[i] = next();
+    }
+    
+    // Return an independent stream -- it gets this state, and this one jumps 2^128 ahead
+    Rng split()
+    {
+        Rng child = *this;
+        jump();
+        return child;
+    }
+    
+    // Scramble a 64-bit value (splitmix64 finalizer) -- handy for deriving seeds
+    static std::uint64_t mix(std::uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    void jump()
+    {
+        static const std::uint64_t JUMP[] = {
+            0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+            0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+        };
+        std::uint64_t s[4] = { 0, 0, 0, 0 };
+        for (int i = 0; i < 4; i++)
+            for (int b = 0; b < 64; b++)
+            {
+                if (JUMP[i] & (std::uint64_t(1) << b))
+                    for (int k = 0; k < 4; k++)
+                        s[k] ^= m_s[k];
+                next();
+            }
+        for (int k = 0; k < 4; k++)
+            m_s[k] = s[k];
+    }
+    std::uint64_t m_s[4];
+};
+
+// Return this thread's generator -- seeded from the system on first use
+inline Rng& threadRng()
+{
+    thread_local Rng rng(std::random_device{}() * 0x100000001ULL ^ std::random_device{}());
+    return rng;
+}
+
+// Reseed this thread's generator, e.g. to make randInt reproducible
+inline void seedRandInt(std::uint64_t seed)
+{
+    threadRng().reseed(seed);
+}
+
 // Return a uniformly distributed random int from 0 to limit-1
 inline int randInt(int limit)
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
-    std::uniform_int_distribution<> distro(0, limit-1);
-    return distro(generator);
+    return threadRng().randInt(limit);
 }
 
 #endif // GLOBALS_INCLUDED
@@ -6,32 +6,53 @@
 
 // not in original skeleton
 #include "Board.h"
+#include "Fleet.h"
+#include "GameObserver.h"
+#include "GameRecord.h"
+#include "Instrument.h"
+#include "Match.h"
+#include "Replay.h"
+#include "Server.h"
+#include "Tournament.h"
+#include "TurnLog.h"
 #include <cassert>
+#include <fstream>
 #include <unordered_set>
 #include <map>
 #include <algorithm>
 #include <stdlib.h>
+#include <sys/resource.h>
 
 using namespace std;
 
 bool addStandardShips(Game& g)
 {
-    return g.addShip(5, 'A', "aircraft carrier")  &&
-    g.addShip(4, 'B', "battleship")  &&
-    g.addShip(3, 'D', "destroyer")  &&
-    g.addShip(3, 'S', "submarine")  &&
-    g.addShip(2, 'P', "patrol boat");
+    return addFleet<StandardFleet>(g);
 }
 
 int main()
 {
-    const int NTRIALS = 100;
+    const long NTOURNAMENT = 1000000;
+    const long NLOGGED = 10000;
+    const long NRECORDED = 10000;
     
     cout << "Select one of these choices for an example of the game:" << endl;
     cout << "  1.  A mini-game between two mediocre players" << endl;
     cout << "  2.  A mediocre player against a human player" << endl;
-    cout << "  3.  A " << NTRIALS
-    << "-game match between a mediocre and an awful player, with no pauses"
+    cout << "  3.  A match between a good and a mediocre player that stops once"
+    << " the winner is clear" << endl;
+    cout << "  4.  A " << NTOURNAMENT
+    << "-game tournament between a good and a mediocre player on all cores"
+    << endl;
+    cout << "  5.  Show a turn of a game from a record file written by choice 9" << endl;
+    cout << "  6.  A game between a good and a mediocre player, redrawn in place"
+    << endl;
+    cout << "  7.  A " << NLOGGED
+    << "-game tournament between a good and a mediocre player, logging every turn"
+    << endl;
+    cout << "  8.  Serve games against a good player to clients on a local socket" << endl;
+    cout << "  9.  A " << NRECORDED
+    << "-game tournament between a good and a mediocre player, recorded to a file"
     << endl;
     cout << "Enter your choice: ";
     string line;
@@ -63,28 +84,147 @@ int main()
     }
     else if (line[0] == '3')
     {
-        int nMediocreWins = 0;
-        
-        for (int k = 1; k <= NTRIALS; k++)
+        // Pairs of games until the sequential test is sure, not a fixed number
+        SequentialMatch m(10, 10, addStandardShips, "good", "mediocre");
+        MatchResult result = m.run();
+        const char* verdicts[] = {
+            "The good player is stronger", "The mediocre player is stronger",
+            "The players are equally strong", "The match was undecided"
+        };
+        cout << verdicts[result.verdict] << " after " << result.games << " games in "
+        << result.seconds << " seconds." << endl;
+        cout << "The good player won " << result.wins1 << " and the mediocre player won "
+        << result.wins2 << ", a score of " << result.score << " +/- " << result.interval
+        << "." << endl;
+        // We'd expect a good player to be called stronger within a few
+        // dozen games; two players of one type should come out equal.
+    }
+    else if (line[0] == '4')
+    {
+        Tournament t(10, 10, addStandardShips, "good", "mediocre");
+        TournamentResult result = t.run(NTOURNAMENT);
+        cout << "The good player won " << result.wins1 << " and the mediocre player won "
+        << result.wins2 << " out of " << result.games << " games in "
+        << result.seconds << " seconds." << endl;
+        // Empty unless built with BATTLESHIP_INSTRUMENT
+        printInstrumentReport(cout);
+    }
+    else if (line[0] == '5')
+    {
+        string path;
+        long game, turn;
+        cout << "Record file: ";
+        getline(cin, path);
+        cout << "Game number and turn: ";
+        cin >> game >> turn;
+        GameRecordReader reader(path);
+        GameRecordView rec;
+        bool found = reader.isOpen();
+        for (long k = 1; found && k <= game; k++)
+            found = reader.next(rec);
+        if (!found)
+        {
+            cout << "There is no game " << game << " in " << path << endl;
+            return 1;
+        }
+        // Jump straight to the turn, then show both boards as they stand
+        Replay r(rec);
+        if (!r.fastForward(turn))
+        {
+            cout << "That game can't be replayed" << endl;
+            return 1;
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            cout << r.player(i).name() << " (" << rec.playerType(i) << "):" << endl;
+            r.board(i).display(false);
+        }
+        if (r.turn() < r.nTurns())
+        {
+            Point p = r.recordedShot(r.turn());
+            cout << "Turn " << r.turn() << ": " << r.player(r.attacker()).name()
+            << " attacked (" << p.r << "," << p.c << ")" << endl;
+        }
+        else
+            cout << "The game ended after " << r.nTurns() << " turns" << endl;
+    }
+    else if (line[0] == '6')
+    {
+        Game g(10, 10);
+        addStandardShips(g);
+        Player* p1 = createPlayer("good", "Good Audrey", g);
+        Player* p2 = createPlayer("mediocre", "Mediocre Mimi", g);
+        // Each turn only redraws the cell that was shot and the status line
+        ConsoleObserver screen(true);
+        g.play(p1, p2, &screen, true);
+        delete p1;
+        delete p2;
+    }
+    else if (line[0] == '7')
+    {
+        string path;
+        cout << "Log file: ";
+        getline(cin, path);
+        ofstream file(path);
+        if (!file)
+        {
+            cout << "Can't write " << path << endl;
+            return 1;
+        }
+        // The games only queue their turns -- the log's own thread formats and writes them
+        TurnLog log(file, LOG_BLOCK);
+        Tournament t(10, 10, addStandardShips, "good", "mediocre");
+        t.log(&log);
+        TournamentResult result = t.run(NLOGGED);
+        cout << "The good player won " << result.wins1 << " and the mediocre player won "
+        << result.wins2 << " out of " << result.games << " games in "
+        << result.seconds << " seconds." << endl;
+    }
+    else if (line[0] == '8')
+    {
+        string where;
+        cout << "Port, or path of a Unix socket: ";
+        getline(cin, where);
+        // Every client holds a descriptor, and thousands of them exceed the usual soft limit
+        rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+        ServerOptions options;
+        options.addShips = addStandardShips;
+        options.seed = threadRng().next();
+        GameServer server(options);
+        bool listening = (!where.empty() && isdigit(static_cast<unsigned char>(where[0])) ?
+                          server.listenTcp(atoi(where.c_str())) : server.listenUnix(where));
+        if (!listening)
+        {
+            cout << "Can't listen on " << where << endl;
+            return 1;
+        }
+        cout << "Serving on " << where << " until killed" << endl;
+        server.run();
+    }
+    else if (line[0] == '9')
+    {
+        string path;
+        cout << "Record file: ";
+        getline(cin, path);
+        GameRecordWriter out(path);
+        if (!out.isOpen())
         {
-            cout << "============================= Game " << k
-            << " =============================" << endl;
-            Game g(10, 10);
-            addStandardShips(g);
-            Player* p1 = createPlayer("good", "Good Audrey", g);
-            Player* p2 = createPlayer("mediocre", "Mediocre Mimi", g);
-            Player* winner = (k % 2 == 1 ?
-                              g.play(p1, p2, false) : g.play(p2, p1, false));
-            if (winner == p2)
-                nMediocreWins++;
-            delete p1;
-            delete p2;
+            cout << "Can't write " << path << endl;
+            return 1;
         }
-        cout << "The mediocre player won " << nMediocreWins << " out of "
-        << NTRIALS << " games." << endl;
-        // We'd expect a mediocre player to win most of the games against
-        // an awful player.  Similarly, a good player should outperform
-        // a mediocre player.
+        // Every game is recorded, in the order the games finish
+        Tournament t(10, 10, addStandardShips, "good", "mediocre");
+        t.record(&out);
+        TournamentResult result = t.run(NRECORDED);
+        out.flush();
+        cout << "The good player won " << result.wins1 << " and the mediocre player won "
+        << result.wins2 << " out of " << result.games << " games in "
+        << result.seconds << " seconds." << endl;
     }
     else
     {